@@ -0,0 +1,121 @@
+#ifndef AST_HPP
+#define AST_HPP
+
+#include "variable.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace GUMLANG {
+
+enum class ExprType {
+    NUMBER,
+    STRING,
+    VARIABLE,
+    RANDOM,
+    BINARY
+};
+
+struct Expr {
+    ExprType type;
+    int line = 0;
+    int column = 0;
+
+    double number = 0.0;    // NUMBER
+    std::string text;       // STRING value or VARIABLE name
+    Variable value;         // NUMBER and STRING, quickened once for the tree evaluator
+    int slot = -1;          // VARIABLE, set by the Resolver
+    bool checked = false;   // VARIABLE may be read before it is assigned
+    bool lastUse = false;   // VARIABLE is overwritten right after, so its value may be moved out
+    char op = 0;            // BINARY: '+', '-', '*' or '/'
+    int minValue = 0;       // RANDOM
+    int maxValue = 0;       // RANDOM
+    std::unique_ptr<Expr> left;
+    std::unique_ptr<Expr> right;
+};
+
+enum class CompareOp {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    GREATER,
+    LESS_EQUAL,
+    GREATER_EQUAL
+};
+
+enum class ConditionType {
+    COMPARE,
+    AND,
+    OR
+};
+
+// Built once by the parser. '&&' binds tighter than '||' and both
+// short-circuit, so 'first' alone can decide the result.
+struct Condition {
+    ConditionType type = ConditionType::COMPARE;
+    std::unique_ptr<Expr> left;        // COMPARE
+    CompareOp op = CompareOp::EQUAL;   // COMPARE
+    std::unique_ptr<Expr> right;       // COMPARE
+    std::unique_ptr<Condition> first;  // AND, OR
+    std::unique_ptr<Condition> second; // AND, OR
+};
+
+struct Stmt;
+using Block = std::vector<std::unique_ptr<Stmt>>;
+
+struct Branch {
+    std::unique_ptr<Condition> condition;
+    Block body;
+};
+
+enum class StmtType {
+    ASSIGN,          // x 0, x = expr, x y
+    COMPOUND_ASSIGN, // x += expr, x -= expr, x *= expr, x /= expr
+    INCREMENT,       // x++
+    DECREMENT,       // x--
+    PRINT,           // print expr, random a b
+    FLUSH,           // flush
+    IF,
+    FOR,
+    STEP_LOOP        // FOR reduced by the Optimizer, see LoopStep
+};
+
+// One update in the body of a loop whose body only adds constants to
+// numeric variables: 'x++', 'x--', 'x += value' or 'x -= value'. The
+// Optimizer turns such loops into STEP_LOOP statements, which apply every
+// update at once (runStepLoop in runtime.hpp).
+struct LoopStep {
+    int slot;
+    StmtType type;  // INCREMENT, DECREMENT or COMPOUND_ASSIGN
+    char op;        // COMPOUND_ASSIGN: '+' or '-'
+    double value;   // COMPOUND_ASSIGN
+};
+
+struct Stmt {
+    StmtType type;
+    int line = 0;
+    int column = 0;
+
+    std::string name;             // target variable
+    int slot = -1;                // target slot, set by the Resolver
+    bool checked = false;         // target may be unassigned when this runs
+    char op = 0;                  // COMPOUND_ASSIGN: '+', '-', '*' or '/'
+    std::unique_ptr<Expr> value;  // ASSIGN, COMPOUND_ASSIGN, PRINT
+
+    std::vector<Branch> branches; // IF: 'if' followed by each 'else if'
+    Block elseBody;               // IF
+    bool hasElse = false;         // IF
+
+    int cycles = 0;               // FOR, STEP_LOOP
+    Block body;                   // FOR
+    std::vector<LoopStep> steps;  // STEP_LOOP
+};
+
+struct Program {
+    Block body;
+    std::vector<std::string> slotNames; // indexed by slot
+};
+
+} // namespace GUMLANG
+
+#endif // AST_HPP
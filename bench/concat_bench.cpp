@@ -0,0 +1,103 @@
+// Mixed string/number concatenation microbenchmark.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I. bench/concat_bench.cpp runtime.cpp variable.cpp output.cpp -o concat_bench
+//
+// Usage:
+//     concat_bench [count]
+//
+// Joins 'count' numbers (whole, fractional, huge, negative, infinite and
+// NaN) to a string with '+', first through the iostream formatting that
+// formatNumber used before and then through binaryOperation, checks that
+// both produce the same text, and reports throughput.
+
+#include "runtime.hpp"
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace GUMLANG;
+
+// formatNumber as it was, through std::ostringstream.
+static std::string formatByStream(double number) {
+    std::ostringstream oss;
+    if (number >= INT_MIN && number <= INT_MAX && std::trunc(number) == number) {
+        oss << static_cast<int>(number);
+    } else {
+        oss << std::fixed << std::setprecision(2) << number;
+    }
+    return oss.str();
+}
+
+static std::vector<double> makeNumbers(size_t count) {
+    std::mt19937_64 rng(12345);
+    std::uniform_int_distribution<int> whole(-100000, 100000);
+    std::uniform_real_distribution<double> fraction(-1000.0, 1000.0);
+    std::uniform_real_distribution<double> exponent(-12.0, 300.0);
+    std::vector<double> numbers = {
+        0.0, -0.0, 0.005, 0.015, 2.675, -2.675, 1e300, -1e300, 2147483647.0, 2147483648.0, -2147483648.0,
+        -2147483649.0, std::numeric_limits<double>::max(), std::numeric_limits<double>::denorm_min(),
+        std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN(),
+    };
+    while (numbers.size() < count) {
+        switch (rng() % 4) {
+            case 0: numbers.push_back(whole(rng)); break;
+            case 1: numbers.push_back(fraction(rng)); break;
+            case 2: numbers.push_back(whole(rng) / 4.0); break;
+            default: numbers.push_back(std::pow(10.0, exponent(rng)) * (rng() % 2 ? 1 : -1)); break;
+        }
+    }
+    return numbers;
+}
+
+template <typename F>
+static double seconds(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::vector<double> numbers = makeNumbers(count);
+    const std::string prefix = "value: ";
+
+    std::vector<std::string> before;
+    before.reserve(numbers.size());
+    double streamTime = seconds([&] {
+        for (double number : numbers) {
+            before.push_back(prefix + formatByStream(number));
+        }
+    });
+
+    std::vector<Variable> after;
+    after.reserve(numbers.size());
+    Variable left(prefix);
+    double charsTime = seconds([&] {
+        for (double number : numbers) {
+            after.push_back(binaryOperation('+', left, Variable(number)));
+        }
+    });
+
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        if (before[i] != after[i].stringValue()) {
+            std::cerr << "Formatting differs for " << numbers[i] << ": \"" << before[i] << "\" vs \""
+                      << after[i].stringValue() << "\"" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << numbers.size() << " concatenations, identical text\n";
+    std::cout << "ostringstream: " << numbers.size() / streamTime / 1e6 << " M/s\n";
+    std::cout << "to_chars:      " << numbers.size() / charsTime / 1e6 << " M/s" << std::endl;
+    return 0;
+}
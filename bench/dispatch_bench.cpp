@@ -0,0 +1,91 @@
+// VM dispatch comparison.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I. bench/dispatch_bench.cpp $(ls *.cpp | grep -v '^main.cpp$') -o dispatch_bench
+//
+// Usage:
+//     dispatch_bench [--runs=N] [--opt-level=N] <program.gum>...
+//
+// Compiles each program once and runs the bytecode with switch dispatch
+// and with threaded (computed goto) dispatch, reporting the best of --runs
+// for each and checking that both print the same output. --opt-level
+// defaults to 1 so that counted loops still execute instruction by
+// instruction. When the build has no threaded dispatch (a compiler without
+// labels-as-values, or -DGUM_DISPATCH_SWITCH), both columns use the switch.
+// Every run uses the same seed, so programs that use random compare too.
+
+#include "compiler.hpp"
+#include "optimizer.hpp"
+#include "parser.hpp"
+#include "vm.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace GUMLANG;
+
+int main(int argc, char* argv[]) {
+    int runs = 5;
+    int optLevel = 1;
+    std::vector<std::string> programs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--runs=", 0) == 0) {
+            runs = std::max(1, std::atoi(arg.c_str() + 7));
+        } else if (arg.rfind("--opt-level=", 0) == 0) {
+            optLevel = std::atoi(arg.c_str() + 12);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        } else {
+            programs.push_back(arg);
+        }
+    }
+    if (programs.empty()) {
+        std::cerr << "Usage: dispatch_bench [--runs=N] [--opt-level=N] <program.gum>..." << std::endl;
+        return 1;
+    }
+
+    std::printf("threaded dispatch %s\n", GUM_DISPATCH_THREADED ? "built" : "not built");
+    std::printf("%-24s %12s %12s %8s\n", "program", "switch ms", "threaded ms", "speedup");
+
+    bool mismatch = false;
+    for (const std::string& path : programs) {
+        Program program;
+        Parser parser(path);
+        if (!parser.parseProgram(program)) return 1;
+        Optimizer(optLevel).optimize(program);
+        Chunk chunk = Compiler().compile(program);
+
+        // Program output goes to memory so only execution is measured,
+        // and so the two strategies can be compared.
+        auto time = [&](Dispatch dispatch, std::string& output) {
+            double best = 0;
+            MemorySink sink;
+            for (int i = 0; i < runs; ++i) {
+                sink.clear();
+                auto start = std::chrono::steady_clock::now();
+                VM(sink, 1).run(chunk, dispatch);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                if (i == 0 || ms < best) best = ms;
+            }
+            output = sink.contents();
+            return best;
+        };
+
+        std::string switchOutput, threadedOutput;
+        double switchMs = time(Dispatch::SWITCH, switchOutput);
+        double threadedMs = time(Dispatch::THREADED, threadedOutput);
+
+        std::string name = path.substr(path.find_last_of('/') + 1);
+        bool same = switchOutput == threadedOutput;
+        mismatch = mismatch || !same;
+        std::printf("%-24s %12.2f %12.2f %7.2fx%s\n", name.c_str(), switchMs, threadedMs, switchMs / threadedMs,
+                    same ? "" : "  OUTPUT DIFFERS");
+    }
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+// Identifier-heavy lexing microbenchmark for keyword classification.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I. bench/keyword_bench.cpp lexer.cpp scan.cpp -o keyword_bench
+//
+// Compares the old chain of string comparisons with the perfect-hash
+// classifier in keywords.hpp on the same words, then reports end-to-end
+// Lexer throughput on the same text.
+
+#include "keywords.hpp"
+#include "lexer.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Classification as Lexer::identifier did it before keywords.hpp.
+static TokenType classifyByComparison(const std::string& value) {
+    if (value == "if") return TokenType::TOKEN_IF;
+    if (value == "then") return TokenType::TOKEN_THEN;
+    if (value == "else") return TokenType::TOKEN_ELSE;
+    if (value == "print") return TokenType::TOKEN_PRINT;
+    if (value == "for") return TokenType::TOKEN_FOR;
+    if (value == "random") return TokenType::TOKEN_RANDOM;
+    return TokenType::TOKEN_IDENTIFIER;
+}
+
+static std::string makeCorpus(size_t bytes) {
+    static const char* words[] = {
+        "x", "counter", "total_sum", "i", "phrase12", "value", "result", "idx",
+        "print", "for", "if", "then", "random", "name", "width", "height"
+    };
+    std::mt19937 rng(12345);
+    std::string text;
+    while (text.size() < bytes) {
+        for (int i = 0; i < 8; ++i) {
+            text += words[rng() % (sizeof(words) / sizeof(words[0]))];
+            text += ' ';
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+template <typename F>
+static double seconds(F&& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 16;
+    std::string corpus = makeCorpus(megabytes << 20);
+    double mb = corpus.size() / 1048576.0;
+
+    // Split once so both classifiers see identical words.
+    std::vector<std::string_view> words;
+    std::string_view text = corpus;
+    size_t start = std::string::npos;
+    for (size_t i = 0; i <= text.size(); ++i) {
+        bool word = i < text.size() && text[i] != ' ' && text[i] != '\n';
+        if (word && start == std::string::npos) start = i;
+        if (!word && start != std::string::npos) {
+            words.push_back(text.substr(start, i - start));
+            start = std::string::npos;
+        }
+    }
+
+    size_t keywordsBefore = 0;
+    double before = seconds([&] {
+        for (std::string_view word : words) {
+            // The old lexer built a std::string for every identifier.
+            std::string value(word);
+            keywordsBefore += classifyByComparison(value) != TokenType::TOKEN_IDENTIFIER;
+        }
+    });
+
+    size_t keywordsAfter = 0;
+    double after = seconds([&] {
+        for (std::string_view word : words) {
+            keywordsAfter += classifyKeyword(word) != TokenType::TOKEN_IDENTIFIER;
+        }
+    });
+
+    if (keywordsBefore != keywordsAfter) {
+        std::cerr << "Classifiers disagree: " << keywordsBefore << " vs " << keywordsAfter << " keywords" << std::endl;
+        return 1;
+    }
+
+    size_t tokens = 0;
+    double lexing = seconds([&] {
+        Lexer lexer(corpus);
+        while (lexer.getNextToken().type != TokenType::TOKEN_EOF) {
+            tokens++;
+        }
+    });
+
+    std::cout << "corpus: " << mb << " MB, " << words.size() << " identifiers, " << keywordsAfter << " keywords\n";
+    std::cout << "classify (string compare chain): " << words.size() / before / 1e6 << " M ident/s\n";
+    std::cout << "classify (perfect hash):         " << words.size() / after / 1e6 << " M ident/s\n";
+    std::cout << "lexer: " << mb / lexing << " MB/s, " << tokens / lexing / 1e6 << " M tokens/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,185 @@
+// Front-end throughput harness.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I. bench/lexer_bench.cpp $(ls *.cpp | grep -v '^main.cpp$') -o lexer_bench
+//
+// Usage:
+//     lexer_bench [--shape=mixed|comments|identifiers|nesting|strings]
+//                 [--size=MB] [--depth=N] [--runs=N] [--keep=file.gum]
+//
+// Generates a synthetic .gum program of the requested shape and size, then
+// times each phase on it: lexing (Lexer::getNextToken over the whole file),
+// parsing (Parser, including variable resolution), compiling to bytecode,
+// and executing on both engines. Each phase reports the best of --runs.
+
+#include "compiler.hpp"
+#include "evaluator.hpp"
+#include "lexer.hpp"
+#include "parser.hpp"
+#include "source.hpp"
+#include "vm.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace GUMLANG;
+
+struct Settings {
+    std::string shape = "mixed";
+    double megabytes = 8;
+    int depth = 12;
+    int runs = 3;
+    std::string keep;
+};
+
+class CorpusWriter {
+public:
+    explicit CorpusWriter(const Settings& settings) : settings(settings), rng(7) {}
+
+    std::string generate() {
+        out << "counter 0\ntext \"\"\n";
+        size_t target = static_cast<size_t>(settings.megabytes * 1048576);
+        while (static_cast<size_t>(out.tellp()) < target) {
+            if (settings.shape == "comments") comments();
+            else if (settings.shape == "identifiers") identifiers();
+            else if (settings.shape == "nesting") nesting();
+            else if (settings.shape == "strings") strings();
+            else {
+                switch (rng() % 4) {
+                    case 0: comments(); break;
+                    case 1: identifiers(); break;
+                    case 2: nesting(); break;
+                    default: strings(); break;
+                }
+            }
+        }
+        out << "print counter\n";
+        return out.str();
+    }
+
+private:
+    std::string word(size_t length) {
+        static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz_0123456789";
+        std::string name(1, 'a' + rng() % 26);
+        while (name.size() < length) name += alphabet[rng() % (sizeof(alphabet) - 1)];
+        return name;
+    }
+
+    void comments() {
+        out << "/* " << std::string(100 + rng() % 900, '*') << "\n   " << word(60) << " */\n";
+        out << "counter++ // " << word(40 + rng() % 160) << "\n";
+    }
+
+    void identifiers() {
+        std::string a = "v_" + word(4 + rng() % 36);
+        std::string b = "v_" + word(4 + rng() % 36);
+        out << a << " " << rng() % 1000 << "\n" << b << " " << a << "\n";
+        out << a << " += " << b << " * 2 + (" << a << " - " << rng() % 10 << ")\n";
+        out << "counter += " << a << " / 4\n";
+    }
+
+    void nesting() {
+        out << "n 0\n";
+        for (int level = 0; level < settings.depth; ++level) {
+            out << std::string(level * 4, ' ') << (level % 2 ? "for 1 {\n" : "if n < 100 {\n");
+        }
+        out << std::string(settings.depth * 4, ' ') << "n++\n";
+        for (int level = settings.depth - 1; level >= 0; --level) {
+            out << std::string(level * 4, ' ') << "}\n";
+        }
+        out << "counter += n\n";
+    }
+
+    void strings() {
+        std::string name = "s_" + word(6);
+        out << name << " \"" << word(200 + rng() % 2000) << "\"\n";
+        out << "text = " << name << " + \" / \" + counter\n";
+    }
+
+    const Settings& settings;
+    std::mt19937 rng;
+    std::ostringstream out;
+};
+
+static double bestOf(int runs, const std::function<void()>& body) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = seconds < best ? seconds : best;
+    }
+    return best;
+}
+
+static void report(const char* phase, double seconds, double megabytes, size_t tokens = 0) {
+    std::printf("%-16s %9.4f s  %9.1f MB/s", phase, seconds, megabytes / seconds);
+    if (tokens != 0) std::printf("  %8.2f M tokens/s", tokens / seconds / 1e6);
+    std::printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--shape=", 0) == 0) settings.shape = arg.substr(8);
+        else if (arg.rfind("--size=", 0) == 0) settings.megabytes = std::atof(arg.c_str() + 7);
+        else if (arg.rfind("--depth=", 0) == 0) settings.depth = std::atoi(arg.c_str() + 8);
+        else if (arg.rfind("--runs=", 0) == 0) settings.runs = std::atoi(arg.c_str() + 7);
+        else if (arg.rfind("--keep=", 0) == 0) settings.keep = arg.substr(7);
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::string path = settings.keep.empty() ? "lexer_bench_corpus.gum" : settings.keep;
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << CorpusWriter(settings).generate();
+    }
+
+    SourceFile source;
+    if (!source.open(path)) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+    double megabytes = source.text().size() / 1048576.0;
+    std::printf("corpus: shape=%s size=%.2f MB depth=%d\n", settings.shape.c_str(), megabytes, settings.depth);
+
+    size_t tokens = 0;
+    double lexing = bestOf(settings.runs, [&] {
+        tokens = 0;
+        Lexer lexer(source.text());
+        while (lexer.getNextToken().type != TokenType::TOKEN_EOF) tokens++;
+    });
+    report("lex", lexing, megabytes, tokens);
+
+    Program program;
+    double parsing = bestOf(settings.runs, [&] {
+        program = Program();
+        Parser parser(path);
+        if (!parser.parseProgram(program)) std::exit(1);
+    });
+    report("parse+resolve", parsing, megabytes);
+
+    Chunk chunk;
+    double compiling = bestOf(settings.runs, [&] { chunk = Compiler().compile(program); });
+    report("compile", compiling, megabytes);
+
+    // Program output is discarded so that only execution is measured.
+    MemorySink sink;
+    double vm = bestOf(settings.runs, [&] { sink.clear(); VM(sink).run(chunk); });
+    double tree = bestOf(settings.runs, [&] { sink.clear(); Evaluator(sink).run(program); });
+    report("execute (vm)", vm, megabytes);
+    report("execute (tree)", tree, megabytes);
+
+    if (settings.keep.empty()) std::remove(path.c_str());
+    return 0;
+}
@@ -0,0 +1,314 @@
+// End-to-end workload runner with regression thresholds.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 bench/run_workloads.cpp -o run_workloads
+//
+// Usage:
+//     run_workloads [--engines=vm,tree] [--opt-levels=0,2] [--runs=N]
+//                   [--threshold=0.25] [--min-wall-ms=5]
+//                   [--baseline=bench/workloads/baseline.txt]
+//                   [--update-baseline]
+//                   <gum binary> <workload.gum>...
+//
+// Runs every workload under every engine (and, with --opt-levels, at each
+// listed --opt-level, named e.g. 'vm-O0'), keeping the fastest of --runs for
+// wall time together with the instructions retired (Linux perf counters,
+// when the kernel allows them) and the peak RSS of that run. Every run
+// gets the same --seed, so workloads that use 'random' are reproducible
+// too, and --no-cache, so every run includes lexing and parsing. The
+// results are compared with the stored baseline, and the runner
+// exits with status 1 when any metric grows by more than --threshold
+// (0.25 = 25%) or when configurations disagree on a workload's output. Wall-time changes
+// smaller than --min-wall-ms are treated as noise. --update-baseline
+// rewrites the baseline from this run instead of comparing.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+struct Measurement {
+    double wallMs = 0;
+    int64_t instructions = -1; // -1 when the counter is unavailable
+    int64_t peakRssKb = 0;
+    uint64_t outputHash = 0;
+    bool ok = false;
+};
+
+// One way of running a workload: an engine, optionally at a fixed
+// optimization level.
+struct Config {
+    std::string name;
+    std::string engine;
+    std::string optLevel;
+};
+
+struct Settings {
+    std::vector<std::string> engines = {"vm", "tree"};
+    std::vector<std::string> optLevels; // empty: the binary's default
+    int runs = 3;
+    double threshold = 0.25;
+    double minWallMs = 5;
+    std::string baseline = "bench/workloads/baseline.txt";
+    bool updateBaseline = false;
+    std::string binary;
+    std::vector<std::string> workloads;
+};
+
+static std::string baseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+static uint64_t hashFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    uint64_t hash = 1469598103934665603ull; // FNV-1a
+    char c;
+    while (file.get(c)) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+#if defined(__linux__)
+static int openInstructionCounter(pid_t pid) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof attr;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, pid, -1, -1, 0));
+}
+#endif
+
+// Runs one process, with stdout sent to 'outputPath'.
+static Measurement runOnce(const std::string& binary, const Config& config, const std::string& workload,
+                           const std::string& outputPath) {
+    Measurement result;
+    int gate[2];
+    if (pipe(gate) != 0) return result;
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Wait until the parent has attached the counter, then exec.
+        close(gate[1]);
+        char go;
+        if (read(gate[0], &go, 1) != 1) _exit(127);
+        int out = open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out >= 0) dup2(out, STDOUT_FILENO);
+        std::string engineArg = "--engine=" + config.engine;
+        std::string optArg = "--opt-level=" + config.optLevel;
+        if (config.optLevel.empty()) {
+            execl(binary.c_str(), binary.c_str(), engineArg.c_str(), "--seed=1", "--no-cache", workload.c_str(),
+                  static_cast<char*>(nullptr));
+        } else {
+            execl(binary.c_str(), binary.c_str(), engineArg.c_str(), optArg.c_str(), "--seed=1", "--no-cache",
+                  workload.c_str(), static_cast<char*>(nullptr));
+        }
+        _exit(127);
+    }
+    close(gate[0]);
+    if (pid < 0) {
+        close(gate[1]);
+        return result;
+    }
+
+    int counter = -1;
+#if defined(__linux__)
+    counter = openInstructionCounter(pid);
+#endif
+    start = std::chrono::steady_clock::now();
+    (void)!write(gate[1], "x", 1);
+    close(gate[1]);
+
+    int status = 0;
+    rusage usage;
+    wait4(pid, &status, 0, &usage);
+    result.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.peakRssKb = usage.ru_maxrss;
+#if defined(__APPLE__)
+    result.peakRssKb /= 1024; // bytes on macOS
+#endif
+    result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    if (counter >= 0) {
+        int64_t count = 0;
+        if (read(counter, &count, sizeof count) == sizeof count) result.instructions = count;
+        close(counter);
+    }
+    result.outputHash = hashFile(outputPath);
+    return result;
+}
+
+static Measurement measure(const Settings& settings, const Config& config, const std::string& workload) {
+    std::string outputPath = "/tmp/gum_workload_" + std::to_string(getpid()) + ".out";
+    Measurement best;
+    for (int i = 0; i < settings.runs; ++i) {
+        Measurement run = runOnce(settings.binary, config, workload, outputPath);
+        if (!run.ok) {
+            std::remove(outputPath.c_str());
+            return run;
+        }
+        if (i == 0 || run.wallMs < best.wallMs) best = run;
+    }
+    std::remove(outputPath.c_str());
+    return best;
+}
+
+static std::map<std::string, Measurement> loadBaseline(const std::string& path) {
+    std::map<std::string, Measurement> baseline;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string workload, engine;
+        Measurement m;
+        if (fields >> workload >> engine >> m.wallMs >> m.instructions >> m.peakRssKb) {
+            baseline[workload + " " + engine] = m;
+        }
+    }
+    return baseline;
+}
+
+static bool regressed(const char* metric, double now, double before, double threshold, std::string& notes) {
+    if (before <= 0 || now <= before * (1 + threshold)) return false;
+    char text[128];
+    std::snprintf(text, sizeof text, " %s +%.0f%%", metric, (now / before - 1) * 100);
+    notes += text;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--engines=", 0) == 0) {
+            settings.engines.clear();
+            std::stringstream list(arg.substr(10));
+            std::string engine;
+            while (std::getline(list, engine, ',')) settings.engines.push_back(engine);
+        } else if (arg.rfind("--opt-levels=", 0) == 0) {
+            settings.optLevels.clear();
+            std::stringstream list(arg.substr(13));
+            std::string level;
+            while (std::getline(list, level, ',')) settings.optLevels.push_back(level);
+        } else if (arg.rfind("--runs=", 0) == 0) {
+            settings.runs = std::max(1, std::atoi(arg.c_str() + 7));
+        } else if (arg.rfind("--threshold=", 0) == 0) {
+            settings.threshold = std::atof(arg.c_str() + 12);
+        } else if (arg.rfind("--min-wall-ms=", 0) == 0) {
+            settings.minWallMs = std::atof(arg.c_str() + 14);
+        } else if (arg.rfind("--baseline=", 0) == 0) {
+            settings.baseline = arg.substr(11);
+        } else if (arg == "--update-baseline") {
+            settings.updateBaseline = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        } else if (settings.binary.empty()) {
+            settings.binary = arg;
+        } else {
+            settings.workloads.push_back(arg);
+        }
+    }
+    if (settings.binary.empty() || settings.workloads.empty()) {
+        std::cerr << "Usage: run_workloads [options] <gum binary> <workload.gum>..." << std::endl;
+        return 1;
+    }
+
+    std::vector<Config> configs;
+    for (const std::string& engine : settings.engines) {
+        if (settings.optLevels.empty()) {
+            configs.push_back({engine, engine, ""});
+        }
+        for (const std::string& level : settings.optLevels) {
+            configs.push_back({engine + "-O" + level, engine, level});
+        }
+    }
+
+    std::map<std::string, Measurement> baseline = loadBaseline(settings.baseline);
+    std::ostringstream updated;
+    updated << "# workload engine wall_ms instructions peak_rss_kb\n";
+    bool failed = false;
+
+    std::printf("%-22s %-8s %10s %14s %10s  %s\n", "workload", "engine", "wall ms", "instructions", "rss KB", "status");
+    for (const std::string& workload : settings.workloads) {
+        std::string name = baseName(workload);
+        // Outputs are compared against the first config that ran.
+        bool haveFirst = false;
+        uint64_t firstHash = 0;
+        std::string firstLabel;
+
+        for (size_t c = 0; c < configs.size(); ++c) {
+            const std::string& label = configs[c].name;
+            Measurement m = measure(settings, configs[c], workload);
+            std::string notes;
+
+            if (!m.ok) {
+                notes = " FAILED to run";
+                failed = true;
+            } else {
+                if (!haveFirst) {
+                    haveFirst = true;
+                    firstHash = m.outputHash;
+                    firstLabel = label;
+                } else if (m.outputHash != firstHash) {
+                    notes += " output differs from " + firstLabel;
+                    failed = true;
+                }
+                auto before = baseline.find(name + " " + label);
+                if (!settings.updateBaseline && before != baseline.end()) {
+                    const Measurement& b = before->second;
+                    bool worse = m.wallMs - b.wallMs > settings.minWallMs &&
+                                 regressed("wall", m.wallMs, b.wallMs, settings.threshold, notes);
+                    if (m.instructions >= 0 && b.instructions > 0) {
+                        worse = regressed("instructions", static_cast<double>(m.instructions), static_cast<double>(b.instructions), settings.threshold, notes) || worse;
+                    }
+                    worse = regressed("rss", static_cast<double>(m.peakRssKb), static_cast<double>(b.peakRssKb), settings.threshold, notes) || worse;
+                    failed = failed || worse;
+                } else if (!settings.updateBaseline) {
+                    notes += " (no baseline)";
+                }
+            }
+
+            std::string instructions = m.instructions >= 0 ? std::to_string(m.instructions) : "n/a";
+            std::printf("%-22s %-8s %10.1f %14s %10lld  %s\n", name.c_str(), label.c_str(), m.wallMs,
+                        instructions.c_str(), static_cast<long long>(m.peakRssKb), notes.empty() ? "ok" : notes.c_str() + 1);
+            updated << name << " " << label << " " << m.wallMs << " " << m.instructions << " " << m.peakRssKb << "\n";
+        }
+    }
+
+    if (settings.updateBaseline) {
+        std::ofstream file(settings.baseline);
+        file << updated.str();
+        std::printf("baseline written to %s\n", settings.baseline.c_str());
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,280 @@
+// Scanning-kernel benchmark and differential check for the Lexer.
+//
+// Build from the repository root:
+//     g++ -std=c++17 -O2 -I. bench/scan_bench.cpp lexer.cpp scan.cpp -o scan_bench
+//
+// Every corpus is lexed by a byte-at-a-time reference lexer (the Lexer as
+// it was before the kernels, advancing one character per step) and then by
+// the Lexer with each kernel set this CPU supports, scalar included, so the
+// line/column bookkeeping of the jumps is checked as well as the kernels.
+// The token streams (type, text, line, column) must match exactly; any
+// difference is printed and the program exits with status 1 before timings
+// are reported.
+
+#include "keywords.hpp"
+#include "lexer.hpp"
+#include "scan.hpp"
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Corpus {
+    const char* name;
+    std::string text;
+};
+
+static std::string randomWord(std::mt19937& rng, size_t length) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+    std::string word(1, 'a' + rng() % 26);
+    while (word.size() < length) word += alphabet[rng() % (sizeof(alphabet) - 1)];
+    return word;
+}
+
+static std::vector<Corpus> makeCorpora(size_t bytes) {
+    std::mt19937 rng(2024);
+    std::vector<Corpus> corpora;
+
+    std::string comments;
+    while (comments.size() < bytes) {
+        comments += "/* " + std::string(200 + rng() % 400, 'c') + "\n * ** / *" + std::string(rng() % 80, ' ') + "*/\n";
+        comments += "x 1 // " + std::string(100 + rng() % 200, 'd') + "\n";
+    }
+    corpora.push_back({"comments", comments});
+
+    std::string identifiers;
+    while (identifiers.size() < bytes) {
+        identifiers += randomWord(rng, 1 + rng() % 40) + " += " + randomWord(rng, 1 + rng() % 40) + "\n";
+    }
+    corpora.push_back({"identifiers", identifiers});
+
+    std::string strings;
+    while (strings.size() < bytes) {
+        strings += "s \"" + std::string(rng() % 300, 's') + (rng() % 4 == 0 ? "\nmore\n" : "") + "\"\n";
+    }
+    corpora.push_back({"strings", strings});
+
+    std::string indented;
+    while (indented.size() < bytes) {
+        indented += std::string(rng() % 48, ' ') + "\t x++\r\n" + std::string(rng() % 8, '\t') + "\f\v print x\n";
+    }
+    corpora.push_back({"whitespace", indented});
+
+    // Odd bytes: high-bit characters, a stray NUL and unterminated
+    // constructs near the end of the input.
+    std::string edges = "x\xC3\xA9 1\n\"abc\xFF\" /* \xE2\x80\x94 */ y_9 2\n";
+    for (int i = 0; i < 64; ++i) edges += "a" + std::string(i, 'b') + " " + std::string(i, ' ') + "\n";
+    edges += "if a >= 1 && b <= 2 || c != 3 { x -= 1 } else if (d) { y *= [2, 3] } else\tiff / 2 /= ! & |\n";
+    edges += "z 1 /* never closed ";
+    corpora.push_back({"edge cases", edges});
+    corpora.push_back({"embedded NUL", std::string("a 1\n/* x\0 */ b 2\n", 17)});
+
+    return corpora;
+}
+
+// The pre-kernel Lexer: every skipped byte goes through advance(), which
+// is the line/column bookkeeping that jumpTo and jumpWithinLine replace.
+// Operators and punctuation never jump, so they are matched from a table
+// instead of repeating the Lexer's branches.
+class ReferenceLexer {
+public:
+    explicit ReferenceLexer(std::string_view source)
+        : source(source), currentChar(source.empty() ? '\0' : source[0]) {}
+
+    Token getNextToken() {
+        skipWhitespace();
+        while (true) {
+            tokenLine = line;
+            tokenColumn = column;
+            if (currentChar == '\0') return {TokenType::TOKEN_EOF, "", tokenLine, tokenColumn};
+            if (currentChar == '\n') {
+                advance();
+                return {TokenType::TOKEN_EOL, "\\n", tokenLine, tokenColumn};
+            }
+            if (currentChar == '/' && peek() == '/') {
+                while (currentChar != '\n' && currentChar != '\0') advance();
+                skipWhitespace();
+                continue;
+            }
+            if (currentChar == '/' && peek() == '*') {
+                advance();
+                advance();
+                while (currentChar != '\0') {
+                    bool star = currentChar == '*';
+                    advance();
+                    if (star && currentChar == '/') {
+                        advance();
+                        break;
+                    }
+                }
+                skipWhitespace();
+                continue;
+            }
+            if (isalpha(static_cast<unsigned char>(currentChar)) || currentChar == '_') return identifier();
+            if (isdigit(static_cast<unsigned char>(currentChar))) {
+                size_t start = index;
+                while (isdigit(static_cast<unsigned char>(currentChar)) || currentChar == '.') advance();
+                return {TokenType::TOKEN_NUMBER, source.substr(start, index - start), tokenLine, tokenColumn};
+            }
+            if (currentChar == '"') {
+                advance();
+                size_t start = index;
+                while (currentChar != '"' && currentChar != '\0') advance();
+                std::string_view value = source.substr(start, index - start);
+                advance();
+                return {TokenType::TOKEN_STRING, value, tokenLine, tokenColumn};
+            }
+            return punctuation();
+        }
+    }
+
+private:
+    std::string_view source;
+    size_t index = 0;
+    int line = 1;
+    int column = 1;
+    int tokenLine = 1;
+    int tokenColumn = 1;
+    char currentChar;
+
+    char peek() const { return index + 1 < source.size() ? source[index + 1] : '\0'; }
+
+    void advance() {
+        if (currentChar == '\0') return;
+        if (currentChar == '\n') {
+            line++;
+            column = 0;
+        }
+        index++;
+        currentChar = index < source.size() ? source[index] : '\0';
+        column++;
+    }
+
+    void skipWhitespace() {
+        while (isspace(static_cast<unsigned char>(currentChar)) && currentChar != '\n') advance();
+    }
+
+    Token identifier() {
+        size_t start = index;
+        while (isalnum(static_cast<unsigned char>(currentChar)) || currentChar == '_') advance();
+        std::string_view value = source.substr(start, index - start);
+        TokenType type = classifyKeyword(value);
+        if (type == TokenType::TOKEN_ELSE) {
+            size_t next = index;
+            while (next < source.size() && (source[next] == ' ' || source[next] == '\t' || source[next] == '\r')) next++;
+            bool elseIf = source.substr(next, 2) == "if" &&
+                          (next + 2 >= source.size() ||
+                           !(isalnum(static_cast<unsigned char>(source[next + 2])) || source[next + 2] == '_'));
+            if (elseIf) {
+                while (index < next + 2) advance();
+                return {TokenType::TOKEN_ELSEIF, source.substr(start, index - start), tokenLine, tokenColumn};
+            }
+        }
+        return {type, value, tokenLine, tokenColumn};
+    }
+
+    Token punctuation() {
+        static const struct {
+            std::string_view text;
+            TokenType type;
+        } spellings[] = {
+            {"==", TokenType::TOKEN_OPERATOR}, {"!=", TokenType::TOKEN_OPERATOR}, {">=", TokenType::TOKEN_OPERATOR},
+            {"<=", TokenType::TOKEN_OPERATOR}, {"&&", TokenType::TOKEN_AND}, {"||", TokenType::TOKEN_OR},
+            {"+=", TokenType::TOKEN_OPERATOR_PLUSEQUAL}, {"-=", TokenType::TOKEN_OPERATOR_MINUSEQUAL},
+            {"*=", TokenType::TOKEN_OPERATOR_STAREQUAL}, {"/=", TokenType::TOKEN_OPERATOR_SLASHEQUAL},
+            {"++", TokenType::TOKEN_OPERATOR_INCREMENT}, {"--", TokenType::TOKEN_OPERATOR_DECREMENT},
+            {"=", TokenType::TOKEN_ASSIGN}, {"+", TokenType::TOKEN_OPERATOR}, {"-", TokenType::TOKEN_OPERATOR},
+            {"*", TokenType::TOKEN_OPERATOR}, {"/", TokenType::TOKEN_OPERATOR}, {">", TokenType::TOKEN_OPERATOR},
+            {"<", TokenType::TOKEN_OPERATOR}, {"{", TokenType::TOKEN_LBRACE}, {"}", TokenType::TOKEN_RBRACE},
+            {"(", TokenType::TOKEN_LPAREN}, {")", TokenType::TOKEN_RPAREN}, {",", TokenType::TOKEN_COMMA},
+            {"[", TokenType::TOKEN_LBRACKET}, {"]", TokenType::TOKEN_RBRACKET},
+        };
+        for (const auto& spelling : spellings) {
+            if (source.substr(index, spelling.text.size()) == spelling.text) {
+                for (size_t i = 0; i < spelling.text.size(); ++i) advance();
+                return {spelling.type, spelling.text, tokenLine, tokenColumn};
+            }
+        }
+        size_t start = index;
+        advance();
+        return {TokenType::TOKEN_UNKNOWN, source.substr(start, 1), tokenLine, tokenColumn};
+    }
+};
+
+template <typename AnyLexer>
+static std::vector<Token> lexAll(AnyLexer& lexer) {
+    std::vector<Token> tokens;
+    while (true) {
+        Token token = lexer.getNextToken();
+        tokens.push_back(token);
+        if (token.type == TokenType::TOKEN_EOF) break;
+    }
+    return tokens;
+}
+
+static std::vector<Token> lexAll(const std::string& text, const ScanKernels& kernels) {
+    Lexer lexer(text, kernels);
+    return lexAll(lexer);
+}
+
+static bool sameTokens(const std::vector<Token>& expected, const std::vector<Token>& actual, const char* corpus, const char* kernels) {
+    for (size_t i = 0; i < expected.size() || i < actual.size(); ++i) {
+        if (i >= expected.size() || i >= actual.size() || expected[i].type != actual[i].type ||
+            expected[i].value != actual[i].value || expected[i].line != actual[i].line ||
+            expected[i].column != actual[i].column) {
+            std::cerr << "Mismatch in '" << corpus << "' with " << kernels << " kernels at token " << i;
+            if (i < expected.size() && i < actual.size()) {
+                std::cerr << ": expected '" << expected[i].value << "' at " << expected[i].line << ":" << expected[i].column
+                          << ", got '" << actual[i].value << "' at " << actual[i].line << ":" << actual[i].column;
+            }
+            std::cerr << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+    std::vector<Corpus> corpora = makeCorpora(megabytes << 20);
+
+    size_t kernelCount = 0;
+    const ScanKernels* const* kernels = availableScanKernels(kernelCount);
+
+    bool ok = true;
+    for (const Corpus& corpus : corpora) {
+        ReferenceLexer reference(corpus.text);
+        std::vector<Token> expected = lexAll(reference);
+        for (size_t k = 0; k < kernelCount; ++k) {
+            ok = sameTokens(expected, lexAll(corpus.text, *kernels[k]), corpus.name, kernels[k]->name) && ok;
+        }
+    }
+    if (!ok) return 1;
+    std::cout << "token streams match the byte-at-a-time lexer with " << kernelCount << " kernel sets" << std::endl;
+
+    for (const Corpus& corpus : corpora) {
+        if (corpus.text.size() < (1u << 20)) continue;
+        double mb = corpus.text.size() / 1048576.0;
+        std::cout << corpus.name << " (" << mb << " MB):";
+        {
+            auto start = std::chrono::steady_clock::now();
+            ReferenceLexer reference(corpus.text);
+            size_t tokens = lexAll(reference).size();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "  byte-at-a-time " << mb / seconds << " MB/s";
+            (void)tokens;
+        }
+        for (size_t k = 0; k < kernelCount; ++k) {
+            auto start = std::chrono::steady_clock::now();
+            size_t tokens = lexAll(corpus.text, *kernels[k]).size();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "  " << kernels[k]->name << " " << mb / seconds << " MB/s";
+            (void)tokens;
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+#include "ast.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace GUMLANG {
+
+enum class OpCode : uint8_t {
+    PUSH_NUMBER,        // a: index into numbers
+    PUSH_STRING,        // a: index into strings
+    LOAD,               // a: slot
+    LOAD_CHECKED,       // a: slot that may not be assigned yet
+    TAKE,               // a: slot whose value is moved out (Expr::lastUse)
+    STORE,              // a: slot
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    ADD_ASSIGN,         // a: slot, pops the right-hand side
+    SUBTRACT_ASSIGN,    // a: slot
+    MULTIPLY_ASSIGN,    // a: slot
+    DIVIDE_ASSIGN,      // a: slot
+    INCREMENT,          // a: slot
+    DECREMENT,          // a: slot
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    GREATER,
+    LESS_EQUAL,
+    GREATER_EQUAL,
+    JUMP,               // a: target
+    JUMP_IF_FALSE,      // a: target, pops the condition
+    JUMP_IF_UNDEFINED,  // a: slot, b: target
+    LOOP_START,         // a: loop counter, b: cycles
+    LOOP_NEXT,          // a: loop counter, b: target of the loop body
+    STEP_LOOP,          // a: index into stepLoops, b: cycles
+    PRINT,
+    FLUSH,
+    RANDOM,             // a: minimum, b: maximum
+
+    // Fused forms of common sequences, chosen by Compiler::fuseInstructions.
+    ADD_SLOT_CONST,      // a: slot, b: index into numbers; PUSH_NUMBER, ADD_ASSIGN
+    SUBTRACT_SLOT_CONST, // a: slot, b: index into numbers; PUSH_NUMBER, SUBTRACT_ASSIGN
+    MOVE_SLOT,           // a: target slot, b: source slot; LOAD, STORE
+    CMP_SLOT_CONST_JUMP, // variant: CompareOp, a: slot, b: index into numbers,
+                         // c: target taken when the comparison fails;
+                         // LOAD, PUSH_NUMBER, compare, JUMP_IF_FALSE
+
+    HALT
+};
+
+struct Instruction {
+    OpCode op;
+    uint8_t variant = 0;
+    int32_t a = 0;
+    int32_t b = 0;
+    int32_t c = 0;
+};
+
+// The steps of one STEP_LOOP: 'count' entries of Chunk::loopSteps from 'first'.
+struct StepRange {
+    uint32_t first;
+    uint32_t count;
+};
+
+struct ChunkView;
+
+// A compiled program: one flat instruction stream plus its constant pools.
+// Every table is a flat array of plain structs, so a chunk can be written
+// to a .gumc file as is and run straight from the mapped file.
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<double> numbers;
+    std::vector<std::string> strings;
+    std::vector<std::string> slotNames;
+    std::vector<LoopStep> loopSteps;
+    std::vector<StepRange> stepLoops;
+    int loopCount = 0;
+
+    ChunkView view() const;
+};
+
+// What the VM reads while running a chunk, wherever its tables live: in a
+// Chunk or in a mapped .gumc file (see BytecodeCache).
+struct ChunkView {
+    const Instruction* code = nullptr;
+    const double* numbers = nullptr;
+    size_t numberCount = 0;
+    const LoopStep* loopSteps = nullptr;
+    const StepRange* stepLoops = nullptr;
+    std::vector<std::string_view> strings;
+    std::vector<std::string_view> slotNames;
+    int loopCount = 0;
+};
+
+inline ChunkView Chunk::view() const {
+    ChunkView view;
+    view.code = code.data();
+    view.numbers = numbers.data();
+    view.numberCount = numbers.size();
+    view.loopSteps = loopSteps.data();
+    view.stepLoops = stepLoops.data();
+    view.strings.assign(strings.begin(), strings.end());
+    view.slotNames.assign(slotNames.begin(), slotNames.end());
+    view.loopCount = loopCount;
+    return view;
+}
+
+} // namespace GUMLANG
+
+#endif // BYTECODE_HPP
@@ -0,0 +1,395 @@
+#include "cache.hpp"
+#include "compiler.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace GUMLANG;
+
+// A .gumc file is a CacheHeader followed by the sections it lists, each
+// starting on an 8-byte boundary so the mapped tables can be used in
+// place. Strings and slot names are StringEntry tables into one shared
+// text section. Multi-byte fields use the byte order of the machine that
+// wrote the file; 'byteOrder' and 'layout' make other machines reject it.
+namespace {
+
+constexpr char cacheMagic[4] = {'G', 'U', 'M', 'C'};
+constexpr uint32_t formatVersion = 2;
+constexpr uint32_t byteOrderMark = 0x01020304;
+constexpr uint32_t structLayout = sizeof(Instruction) | sizeof(LoopStep) << 8 | sizeof(StepRange) << 16;
+
+struct Section {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct StringEntry {
+    uint64_t offset; // into the text section
+    uint64_t length;
+};
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t formatVersion;
+    uint32_t compilerVersion;
+    uint32_t byteOrder;
+    uint32_t layout;
+    int32_t optLevel;
+    int32_t loopCount;
+    uint32_t reserved;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint64_t payloadHash; // the header from loopCount on, then everything after it
+    Section code;
+    Section numbers;
+    Section loopSteps;
+    Section stepLoops;
+    Section strings;
+    Section slotNames;
+    Section text;
+};
+
+// FNV-1a; cheap, and plenty to tell one version of a script from another.
+// Passing the previous result as 'hash' continues it over more bytes.
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3;
+    }
+    return hash;
+}
+
+// Covers the header fields that describe the payload (loopCount and the
+// section table; payloadHash itself counts as zero) and the payload, so a
+// damaged section offset or count is caught like a damaged record.
+uint64_t payloadHash(const char* file, size_t size) {
+    CacheHeader header;
+    std::memcpy(&header, file, sizeof header);
+    header.payloadHash = 0;
+    const char* fields = reinterpret_cast<const char*>(&header) + offsetof(CacheHeader, loopCount);
+    uint64_t hash = hashBytes(fields, sizeof header - offsetof(CacheHeader, loopCount));
+    return hashBytes(file + sizeof header, size - sizeof header, hash);
+}
+
+// Appends 'count' records of 'size' bytes at the next 8-byte boundary.
+Section appendSection(std::string& file, const void* records, size_t count, size_t size) {
+    file.resize((file.size() + 7) & ~size_t(7), '\0');
+    Section section = {file.size(), count};
+    if (count > 0) file.append(static_cast<const char*>(records), count * size);
+    return section;
+}
+
+// Checks that a section lies inside the file and returns its first record.
+template <typename T>
+const T* sectionData(const char* file, size_t fileSize, const Section& section) {
+    if (section.offset % alignof(T) != 0 || section.offset > fileSize) return nullptr;
+    if (section.count > (fileSize - section.offset) / sizeof(T)) return nullptr;
+    return reinterpret_cast<const T*>(file + section.offset);
+}
+
+bool readStrings(const StringEntry* entries, size_t count, const char* text, size_t textSize,
+                 std::vector<std::string_view>& strings) {
+    strings.clear();
+    strings.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (entries[i].offset > textSize || entries[i].length > textSize - entries[i].offset) return false;
+        strings.emplace_back(text + entries[i].offset, entries[i].length);
+    }
+    return true;
+}
+
+bool inRange(int64_t index, uint64_t count) {
+    return index >= 0 && static_cast<uint64_t>(index) < count;
+}
+
+// The VM trusts every operand, so each index is checked once here against
+// the table it selects: a file that matches its hashes but was written
+// wrongly must not make the VM read or jump outside the chunk.
+bool validChunk(const CacheHeader& header, const ChunkView& chunk) {
+    uint64_t codeCount = header.code.count;
+    uint64_t slots = header.slotNames.count;
+    uint64_t numbers = header.numbers.count;
+    if (header.loopCount < 0 || chunk.code[codeCount - 1].op != OpCode::HALT) return false;
+    uint64_t loops = static_cast<uint64_t>(header.loopCount);
+
+    for (uint64_t i = 0; i < header.loopSteps.count; ++i) {
+        const LoopStep& step = chunk.loopSteps[i];
+        bool update = step.type == StmtType::INCREMENT || step.type == StmtType::DECREMENT ||
+                      (step.type == StmtType::COMPOUND_ASSIGN && (step.op == '+' || step.op == '-'));
+        if (!inRange(step.slot, slots) || !update) return false;
+    }
+    for (uint64_t i = 0; i < header.stepLoops.count; ++i) {
+        const StepRange& range = chunk.stepLoops[i];
+        if (range.first > header.loopSteps.count || range.count > header.loopSteps.count - range.first) return false;
+    }
+
+    for (uint64_t i = 0; i < codeCount; ++i) {
+        const Instruction& ins = chunk.code[i];
+        bool valid;
+        switch (ins.op) {
+            case OpCode::PUSH_NUMBER: valid = inRange(ins.a, numbers); break;
+            case OpCode::PUSH_STRING: valid = inRange(ins.a, header.strings.count); break;
+            case OpCode::LOAD:
+            case OpCode::LOAD_CHECKED:
+            case OpCode::TAKE:
+            case OpCode::STORE:
+            case OpCode::ADD_ASSIGN:
+            case OpCode::SUBTRACT_ASSIGN:
+            case OpCode::MULTIPLY_ASSIGN:
+            case OpCode::DIVIDE_ASSIGN:
+            case OpCode::INCREMENT:
+            case OpCode::DECREMENT: valid = inRange(ins.a, slots); break;
+            case OpCode::JUMP:
+            case OpCode::JUMP_IF_FALSE: valid = inRange(ins.a, codeCount); break;
+            case OpCode::JUMP_IF_UNDEFINED: valid = inRange(ins.a, slots) && inRange(ins.b, codeCount); break;
+            case OpCode::LOOP_START: valid = inRange(ins.a, loops); break;
+            case OpCode::LOOP_NEXT: valid = inRange(ins.a, loops) && inRange(ins.b, codeCount); break;
+            case OpCode::STEP_LOOP: valid = inRange(ins.a, header.stepLoops.count); break;
+            case OpCode::ADD_SLOT_CONST:
+            case OpCode::SUBTRACT_SLOT_CONST: valid = inRange(ins.a, slots) && inRange(ins.b, numbers); break;
+            case OpCode::MOVE_SLOT: valid = inRange(ins.a, slots) && inRange(ins.b, slots); break;
+            case OpCode::CMP_SLOT_CONST_JUMP:
+                valid = ins.variant <= static_cast<uint8_t>(CompareOp::GREATER_EQUAL) && inRange(ins.a, slots) &&
+                        inRange(ins.b, numbers) && inRange(ins.c, codeCount);
+                break;
+            case OpCode::ADD:
+            case OpCode::SUBTRACT:
+            case OpCode::MULTIPLY:
+            case OpCode::DIVIDE:
+            case OpCode::EQUAL:
+            case OpCode::NOT_EQUAL:
+            case OpCode::LESS:
+            case OpCode::GREATER:
+            case OpCode::LESS_EQUAL:
+            case OpCode::GREATER_EQUAL:
+            case OpCode::PRINT:
+            case OpCode::FLUSH:
+            case OpCode::RANDOM:
+            case OpCode::HALT: valid = true; break;
+            default: valid = false; break; // not an opcode
+        }
+        if (!valid) return false;
+    }
+    return true;
+}
+
+// The structs are copied member by member into value-initialized (and so
+// zero-filled) records, so padding bytes never carry stray memory into the
+// file.
+std::vector<Instruction> codeRecords(const std::vector<Instruction>& code) {
+    std::vector<Instruction> records(code.size());
+    for (size_t i = 0; i < code.size(); ++i) {
+        records[i].op = code[i].op;
+        records[i].variant = code[i].variant;
+        records[i].a = code[i].a;
+        records[i].b = code[i].b;
+        records[i].c = code[i].c;
+    }
+    return records;
+}
+
+std::vector<LoopStep> loopStepRecords(const std::vector<LoopStep>& steps) {
+    std::vector<LoopStep> records(steps.size());
+    for (size_t i = 0; i < steps.size(); ++i) {
+        records[i].slot = steps[i].slot;
+        records[i].type = steps[i].type;
+        records[i].op = steps[i].op;
+        records[i].value = steps[i].value;
+    }
+    return records;
+}
+
+std::vector<StringEntry> stringEntries(const std::vector<std::string>& strings, std::string& text) {
+    std::vector<StringEntry> entries;
+    for (const std::string& value : strings) {
+        entries.push_back({text.size(), value.size()});
+        text += value;
+    }
+    return entries;
+}
+
+} // namespace
+
+MappedChunk::MappedChunk(MappedChunk&& other) noexcept
+    : data(other.data), size(other.size), chunk(std::move(other.chunk)) {
+    other.data = nullptr;
+    other.size = 0;
+}
+
+MappedChunk& MappedChunk::operator=(MappedChunk&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data = other.data;
+        size = other.size;
+        chunk = std::move(other.chunk);
+        other.data = nullptr;
+        other.size = 0;
+    }
+    return *this;
+}
+
+MappedChunk::~MappedChunk() {
+    unmap();
+}
+
+void MappedChunk::unmap() {
+#if !defined(_WIN32)
+    if (data) munmap(data, size);
+#endif
+    data = nullptr;
+    size = 0;
+    chunk = ChunkView();
+}
+
+std::string BytecodeCache::defaultDirectory() {
+    if (const char* directory = std::getenv("GUM_CACHE_DIR")) return directory;
+    if (const char* cacheHome = std::getenv("XDG_CACHE_HOME")) {
+        if (*cacheHome) return std::string(cacheHome) + "/gum";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        if (*home) return std::string(home) + "/.cache/gum";
+    }
+    return "";
+}
+
+// One file per source path: the file name, so the directory stays
+// readable, plus a hash of the full path, so equal names in different
+// directories do not evict each other.
+std::string BytecodeCache::cachePath(const std::string& sourcePath) const {
+    std::string fullPath = sourcePath;
+#if !defined(_WIN32)
+    if (char* resolved = realpath(sourcePath.c_str(), nullptr)) {
+        fullPath = resolved;
+        std::free(resolved);
+    }
+#endif
+    std::string name = fullPath.substr(fullPath.find_last_of('/') + 1);
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".gum") == 0) name.resize(name.size() - 4);
+
+    char hash[17];
+    std::snprintf(hash, sizeof hash, "%016llx", static_cast<unsigned long long>(hashBytes(fullPath.data(), fullPath.size())));
+    return directory + "/" + name + "-" + hash + ".gumc";
+}
+
+MappedChunk BytecodeCache::load(const std::string& sourcePath, std::string_view source, int optLevel) const {
+    MappedChunk mapped;
+#if !defined(_WIN32)
+    if (directory.empty()) return mapped;
+
+    int fd = ::open(cachePath(sourcePath).c_str(), O_RDONLY);
+    if (fd < 0) return mapped;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || static_cast<size_t>(info.st_size) < sizeof(CacheHeader)) {
+        ::close(fd);
+        return mapped;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) return mapped;
+    mapped.data = data;
+    mapped.size = size;
+
+    const char* file = static_cast<const char*>(data);
+    const CacheHeader& header = *reinterpret_cast<const CacheHeader*>(file);
+    if (std::memcmp(header.magic, cacheMagic, sizeof cacheMagic) != 0 || header.formatVersion != formatVersion ||
+        header.compilerVersion != Compiler::version || header.byteOrder != byteOrderMark ||
+        header.layout != structLayout || header.optLevel != optLevel || header.sourceSize != source.size() ||
+        header.sourceHash != hashBytes(source.data(), source.size()) ||
+        header.payloadHash != payloadHash(file, size)) {
+        return MappedChunk();
+    }
+
+    ChunkView& chunk = mapped.chunk;
+    const StringEntry* strings = sectionData<StringEntry>(file, size, header.strings);
+    const StringEntry* slotNames = sectionData<StringEntry>(file, size, header.slotNames);
+    const char* text = sectionData<char>(file, size, header.text);
+    chunk.code = sectionData<Instruction>(file, size, header.code);
+    chunk.numbers = sectionData<double>(file, size, header.numbers);
+    chunk.numberCount = header.numbers.count;
+    chunk.loopSteps = sectionData<LoopStep>(file, size, header.loopSteps);
+    chunk.stepLoops = sectionData<StepRange>(file, size, header.stepLoops);
+    chunk.loopCount = header.loopCount;
+    if (!chunk.code || header.code.count == 0 || !chunk.numbers || !chunk.loopSteps || !chunk.stepLoops ||
+        !strings || !slotNames || !text ||
+        !readStrings(strings, header.strings.count, text, header.text.count, chunk.strings) ||
+        !readStrings(slotNames, header.slotNames.count, text, header.text.count, chunk.slotNames) ||
+        !validChunk(header, chunk)) {
+        return MappedChunk();
+    }
+#endif
+    return mapped;
+}
+
+bool BytecodeCache::store(const std::string& sourcePath, std::string_view source, int optLevel,
+                          const Chunk& chunk) const {
+#if !defined(_WIN32)
+    if (directory.empty()) return false;
+
+    // mkdir -p; an existing directory is fine, anything else shows up when
+    // the file is opened.
+    for (size_t slash = directory.find('/', 1); ; slash = directory.find('/', slash + 1)) {
+        std::string prefix = directory.substr(0, slash);
+        if (::mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if (slash == std::string::npos) break;
+    }
+
+    CacheHeader header;
+    std::memset(&header, 0, sizeof header);
+    std::string file(sizeof header, '\0');
+    std::string text;
+    std::vector<Instruction> code = codeRecords(chunk.code);
+    std::vector<LoopStep> loopSteps = loopStepRecords(chunk.loopSteps);
+    std::vector<StringEntry> strings = stringEntries(chunk.strings, text);
+    std::vector<StringEntry> slotNames = stringEntries(chunk.slotNames, text);
+
+    std::memcpy(header.magic, cacheMagic, sizeof cacheMagic);
+    header.formatVersion = formatVersion;
+    header.compilerVersion = Compiler::version;
+    header.byteOrder = byteOrderMark;
+    header.layout = structLayout;
+    header.optLevel = optLevel;
+    header.loopCount = chunk.loopCount;
+    header.sourceHash = hashBytes(source.data(), source.size());
+    header.sourceSize = source.size();
+    header.code = appendSection(file, code.data(), code.size(), sizeof(Instruction));
+    header.numbers = appendSection(file, chunk.numbers.data(), chunk.numbers.size(), sizeof(double));
+    header.loopSteps = appendSection(file, loopSteps.data(), loopSteps.size(), sizeof(LoopStep));
+    header.stepLoops = appendSection(file, chunk.stepLoops.data(), chunk.stepLoops.size(), sizeof(StepRange));
+    header.strings = appendSection(file, strings.data(), strings.size(), sizeof(StringEntry));
+    header.slotNames = appendSection(file, slotNames.data(), slotNames.size(), sizeof(StringEntry));
+    header.text = appendSection(file, text.data(), text.size(), 1);
+    std::memcpy(&file[0], &header, sizeof header);
+    header.payloadHash = payloadHash(file.data(), file.size());
+    std::memcpy(&file[0], &header, sizeof header);
+
+    std::string path = cachePath(sourcePath);
+    std::string temporary = path + ".tmp" + std::to_string(::getpid());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out.write(file.data(), file.size()) || !out.flush()) {
+            out.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,61 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include "bytecode.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace GUMLANG {
+
+// A compiled chunk mapped read-only from a .gumc file. The view points
+// straight into the mapping, which lives as long as this object.
+class MappedChunk {
+public:
+    MappedChunk() = default;
+    MappedChunk(MappedChunk&& other) noexcept;
+    MappedChunk& operator=(MappedChunk&& other) noexcept;
+    MappedChunk(const MappedChunk&) = delete;
+    MappedChunk& operator=(const MappedChunk&) = delete;
+    ~MappedChunk();
+
+    explicit operator bool() const { return data != nullptr; }
+    const ChunkView& view() const { return chunk; }
+
+private:
+    friend class BytecodeCache;
+    void unmap();
+
+    void* data = nullptr;
+    size_t size = 0;
+    ChunkView chunk;
+};
+
+// Compiled programs kept on disk between runs, one .gumc file per source
+// file. A file records the hash and size of the source it was compiled
+// from, the optimization level, Compiler::version and the layout of the
+// structs it holds; load() rejects it when any of them differ, when the
+// file is damaged or when an instruction refers outside the chunk, and the
+// caller compiles again and store()s the result over it. Files are written to a temporary name and renamed into place, so
+// concurrent runs see either the old file or the new one.
+class BytecodeCache {
+public:
+    explicit BytecodeCache(std::string directory) : directory(std::move(directory)) {}
+
+    // $GUM_CACHE_DIR, else gum/ under $XDG_CACHE_HOME or ~/.cache; empty
+    // when none of them is set, which disables the cache.
+    static std::string defaultDirectory();
+
+    MappedChunk load(const std::string& sourcePath, std::string_view source, int optLevel) const;
+    bool store(const std::string& sourcePath, std::string_view source, int optLevel, const Chunk& chunk) const;
+
+private:
+    std::string cachePath(const std::string& sourcePath) const;
+
+    std::string directory;
+};
+
+} // namespace GUMLANG
+
+#endif // CACHE_HPP
@@ -0,0 +1,377 @@
+#include "compiler.hpp"
+#include <cstring>
+using namespace GUMLANG;
+
+Chunk Compiler::compile(const Program& program) {
+    chunk = Chunk();
+    chunk.slotNames = program.slotNames;
+    numberIndex.clear();
+    stringIndex.clear();
+
+    compileBlock(program.body);
+    emit(OpCode::HALT);
+    threadJumps();
+    fuseInstructions();
+    return std::move(chunk);
+}
+
+void Compiler::compileBlock(const Block& block) {
+    for (const auto& stmt : block) {
+        compileStatement(*stmt);
+    }
+}
+
+void Compiler::compileStatement(const Stmt& stmt) {
+    switch (stmt.type) {
+        case StmtType::ASSIGN:
+            compileExpression(*stmt.value);
+            emit(OpCode::STORE, stmt.slot);
+            break;
+        case StmtType::COMPOUND_ASSIGN: {
+            // The right-hand side is only evaluated when the target exists.
+            int guard = guardTarget(stmt);
+            compileExpression(*stmt.value);
+            switch (stmt.op) {
+                case '+': emit(OpCode::ADD_ASSIGN, stmt.slot); break;
+                case '-': emit(OpCode::SUBTRACT_ASSIGN, stmt.slot); break;
+                case '*': emit(OpCode::MULTIPLY_ASSIGN, stmt.slot); break;
+                case '/': emit(OpCode::DIVIDE_ASSIGN, stmt.slot); break;
+            }
+            patchGuard(guard);
+            break;
+        }
+        case StmtType::INCREMENT: {
+            int guard = guardTarget(stmt);
+            emit(OpCode::INCREMENT, stmt.slot);
+            patchGuard(guard);
+            break;
+        }
+        case StmtType::DECREMENT: {
+            int guard = guardTarget(stmt);
+            emit(OpCode::DECREMENT, stmt.slot);
+            patchGuard(guard);
+            break;
+        }
+        case StmtType::PRINT:
+            compileExpression(*stmt.value);
+            emit(OpCode::PRINT);
+            break;
+        case StmtType::FLUSH:
+            emit(OpCode::FLUSH);
+            break;
+        case StmtType::IF:
+            compileIf(stmt);
+            break;
+        case StmtType::FOR:
+            compileFor(stmt);
+            break;
+        case StmtType::STEP_LOOP:
+            emit(OpCode::STEP_LOOP, static_cast<int32_t>(chunk.stepLoops.size()), stmt.cycles);
+            chunk.stepLoops.push_back({static_cast<uint32_t>(chunk.loopSteps.size()),
+                                       static_cast<uint32_t>(stmt.steps.size())});
+            chunk.loopSteps.insert(chunk.loopSteps.end(), stmt.steps.begin(), stmt.steps.end());
+            break;
+    }
+}
+
+void Compiler::compileIf(const Stmt& stmt) {
+    std::vector<int> exits;
+
+    for (size_t i = 0; i < stmt.branches.size(); ++i) {
+        const Branch& branch = stmt.branches[i];
+        std::vector<int> skips;
+        compileCondition(*branch.condition, skips);
+        compileBlock(branch.body);
+
+        bool last = i + 1 == stmt.branches.size() && !stmt.hasElse;
+        if (!last) {
+            exits.push_back(emit(OpCode::JUMP));
+        }
+        for (int skip : skips) {
+            patchJump(skip);
+        }
+    }
+
+    if (stmt.hasElse) {
+        compileBlock(stmt.elseBody);
+    }
+    for (int exit : exits) {
+        patchJump(exit);
+    }
+}
+
+//     LOOP_START counter, cycles
+//     JUMP next
+// body:
+//     ...
+// next:
+//     LOOP_NEXT counter, body
+void Compiler::compileFor(const Stmt& stmt) {
+    int counter = chunk.loopCount++;
+    emit(OpCode::LOOP_START, counter, stmt.cycles);
+    int enter = emit(OpCode::JUMP);
+    int body = static_cast<int>(chunk.code.size());
+    compileBlock(stmt.body);
+    patchJump(enter);
+    emit(OpCode::LOOP_NEXT, counter, body);
+}
+
+// Falls through when the condition holds and otherwise takes one of the
+// jumps added to 'falseJumps', which the caller patches. '&&' and '||'
+// short-circuit by jumping past the operand they no longer need.
+void Compiler::compileCondition(const Condition& condition, std::vector<int>& falseJumps) {
+    switch (condition.type) {
+        case ConditionType::AND:
+            compileCondition(*condition.first, falseJumps);
+            compileCondition(*condition.second, falseJumps);
+            return;
+        case ConditionType::OR: {
+            std::vector<int> tryNext;
+            compileCondition(*condition.first, tryNext);
+            int holds = emit(OpCode::JUMP);
+            for (int jump : tryNext) {
+                patchJump(jump);
+            }
+            compileCondition(*condition.second, falseJumps);
+            patchJump(holds);
+            return;
+        }
+        case ConditionType::COMPARE:
+            break;
+    }
+
+    compileExpression(*condition.left);
+    compileExpression(*condition.right);
+    switch (condition.op) {
+        case CompareOp::EQUAL: emit(OpCode::EQUAL); break;
+        case CompareOp::NOT_EQUAL: emit(OpCode::NOT_EQUAL); break;
+        case CompareOp::LESS: emit(OpCode::LESS); break;
+        case CompareOp::GREATER: emit(OpCode::GREATER); break;
+        case CompareOp::LESS_EQUAL: emit(OpCode::LESS_EQUAL); break;
+        case CompareOp::GREATER_EQUAL: emit(OpCode::GREATER_EQUAL); break;
+    }
+    falseJumps.push_back(emit(OpCode::JUMP_IF_FALSE));
+}
+
+void Compiler::compileExpression(const Expr& expr) {
+    switch (expr.type) {
+        case ExprType::NUMBER:
+            emit(OpCode::PUSH_NUMBER, numberConstant(expr.number));
+            break;
+        case ExprType::STRING:
+            emit(OpCode::PUSH_STRING, stringConstant(expr.text));
+            break;
+        case ExprType::VARIABLE:
+            emit(expr.lastUse ? OpCode::TAKE : expr.checked ? OpCode::LOAD_CHECKED : OpCode::LOAD, expr.slot);
+            break;
+        case ExprType::RANDOM:
+            emit(OpCode::RANDOM, expr.minValue, expr.maxValue);
+            break;
+        case ExprType::BINARY:
+            compileExpression(*expr.left);
+            compileExpression(*expr.right);
+            switch (expr.op) {
+                case '+': emit(OpCode::ADD); break;
+                case '-': emit(OpCode::SUBTRACT); break;
+                case '*': emit(OpCode::MULTIPLY); break;
+                case '/': emit(OpCode::DIVIDE); break;
+            }
+            break;
+    }
+}
+
+// Retargets every jump that lands on an unconditional JUMP to that jump's
+// final destination. Leaving a branch nested inside other branches then
+// takes one jump instead of one per enclosing if.
+void Compiler::threadJumps() {
+    auto finalTarget = [&](int32_t target) {
+        for (size_t hops = 0; hops < chunk.code.size() && chunk.code[target].op == OpCode::JUMP; ++hops) {
+            target = chunk.code[target].a;
+        }
+        return target;
+    };
+
+    for (Instruction& ins : chunk.code) {
+        switch (ins.op) {
+            case OpCode::JUMP:
+            case OpCode::JUMP_IF_FALSE:
+                ins.a = finalTarget(ins.a);
+                break;
+            case OpCode::JUMP_IF_UNDEFINED:
+            case OpCode::LOOP_NEXT:
+                ins.b = finalTarget(ins.b);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static bool isComparison(OpCode op, CompareOp& compare) {
+    switch (op) {
+        case OpCode::EQUAL: compare = CompareOp::EQUAL; return true;
+        case OpCode::NOT_EQUAL: compare = CompareOp::NOT_EQUAL; return true;
+        case OpCode::LESS: compare = CompareOp::LESS; return true;
+        case OpCode::GREATER: compare = CompareOp::GREATER; return true;
+        case OpCode::LESS_EQUAL: compare = CompareOp::LESS_EQUAL; return true;
+        case OpCode::GREATER_EQUAL: compare = CompareOp::GREATER_EQUAL; return true;
+        default: return false;
+    }
+}
+
+// 'k < x' is 'x > k' and so on, for numbers and for the type error alike.
+static CompareOp mirror(CompareOp compare) {
+    switch (compare) {
+        case CompareOp::LESS: return CompareOp::GREATER;
+        case CompareOp::GREATER: return CompareOp::LESS;
+        case CompareOp::LESS_EQUAL: return CompareOp::GREATER_EQUAL;
+        case CompareOp::GREATER_EQUAL: return CompareOp::LESS_EQUAL;
+        default: return compare;
+    }
+}
+
+// Peephole pass: replaces the instruction sequences of 'x += k', 'x -= k',
+// 'x = y' and 'if x <op> k' with one fused instruction each. A sequence is
+// only fused when no jump lands inside it; every jump target is renumbered
+// afterwards.
+void Compiler::fuseInstructions() {
+    const std::vector<Instruction>& code = chunk.code;
+    std::vector<bool> isTarget(code.size() + 1, false);
+    for (const Instruction& ins : code) {
+        switch (ins.op) {
+            case OpCode::JUMP:
+            case OpCode::JUMP_IF_FALSE:
+                isTarget[ins.a] = true;
+                break;
+            case OpCode::JUMP_IF_UNDEFINED:
+            case OpCode::LOOP_NEXT:
+                isTarget[ins.b] = true;
+                break;
+            default:
+                break;
+        }
+    }
+    auto matches = [&](size_t at, std::initializer_list<OpCode> ops) {
+        if (at + ops.size() > code.size()) return false;
+        size_t i = at;
+        for (OpCode op : ops) {
+            if (code[i].op != op || (i > at && isTarget[i])) return false;
+            i++;
+        }
+        return true;
+    };
+
+    std::vector<Instruction> fused;
+    fused.reserve(code.size());
+    std::vector<int32_t> newIndex(code.size() + 1);
+    for (size_t i = 0; i < code.size();) {
+        Instruction ins = code[i];
+        size_t length = 1;
+        CompareOp compare;
+
+        if (i + 3 < code.size() && isComparison(code[i + 2].op, compare) &&
+            code[i + 3].op == OpCode::JUMP_IF_FALSE && !isTarget[i + 1] && !isTarget[i + 2] && !isTarget[i + 3] &&
+            ((code[i].op == OpCode::LOAD && code[i + 1].op == OpCode::PUSH_NUMBER) ||
+             (code[i].op == OpCode::PUSH_NUMBER && code[i + 1].op == OpCode::LOAD))) {
+            bool slotFirst = code[i].op == OpCode::LOAD;
+            const Instruction& load = slotFirst ? code[i] : code[i + 1];
+            const Instruction& constant = slotFirst ? code[i + 1] : code[i];
+            ins = Instruction();
+            ins.op = OpCode::CMP_SLOT_CONST_JUMP;
+            ins.variant = static_cast<uint8_t>(slotFirst ? compare : mirror(compare));
+            ins.a = load.a;
+            ins.b = constant.a;
+            ins.c = code[i + 3].a;
+            length = 4;
+        } else if (matches(i, {OpCode::PUSH_NUMBER, OpCode::ADD_ASSIGN}) ||
+                   matches(i, {OpCode::PUSH_NUMBER, OpCode::SUBTRACT_ASSIGN})) {
+            bool add = code[i + 1].op == OpCode::ADD_ASSIGN;
+            ins = Instruction();
+            ins.op = add ? OpCode::ADD_SLOT_CONST : OpCode::SUBTRACT_SLOT_CONST;
+            ins.a = code[i + 1].a;
+            ins.b = code[i].a;
+            length = 2;
+        } else if (matches(i, {OpCode::LOAD, OpCode::STORE})) {
+            ins = Instruction();
+            ins.op = OpCode::MOVE_SLOT;
+            ins.a = code[i + 1].a;
+            ins.b = code[i].a;
+            length = 2;
+        }
+
+        for (size_t k = 0; k < length; ++k) {
+            newIndex[i + k] = static_cast<int32_t>(fused.size());
+        }
+        fused.push_back(ins);
+        i += length;
+    }
+    newIndex[code.size()] = static_cast<int32_t>(fused.size());
+
+    for (Instruction& ins : fused) {
+        switch (ins.op) {
+            case OpCode::JUMP:
+            case OpCode::JUMP_IF_FALSE:
+                ins.a = newIndex[ins.a];
+                break;
+            case OpCode::JUMP_IF_UNDEFINED:
+            case OpCode::LOOP_NEXT:
+                ins.b = newIndex[ins.b];
+                break;
+            case OpCode::CMP_SLOT_CONST_JUMP:
+                ins.c = newIndex[ins.c];
+                break;
+            default:
+                break;
+        }
+    }
+    chunk.code = std::move(fused);
+}
+
+int Compiler::emit(OpCode op, int32_t a, int32_t b) {
+    Instruction ins;
+    ins.op = op;
+    ins.a = a;
+    ins.b = b;
+    chunk.code.push_back(ins);
+    return static_cast<int>(chunk.code.size()) - 1;
+}
+
+void Compiler::patchJump(int at) {
+    chunk.code[at].a = static_cast<int32_t>(chunk.code.size());
+}
+
+// Statements whose target may still be unassigned skip themselves, after
+// reporting it, when it is. Returns -1 when no guard is needed.
+int Compiler::guardTarget(const Stmt& stmt) {
+    if (!stmt.checked) return -1;
+    return emit(OpCode::JUMP_IF_UNDEFINED, stmt.slot);
+}
+
+void Compiler::patchGuard(int at) {
+    if (at < 0) return;
+    chunk.code[at].b = static_cast<int32_t>(chunk.code.size());
+}
+
+int Compiler::numberConstant(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    auto it = numberIndex.find(bits);
+    if (it != numberIndex.end()) {
+        return it->second;
+    }
+    int index = static_cast<int>(chunk.numbers.size());
+    chunk.numbers.push_back(value);
+    numberIndex[bits] = index;
+    return index;
+}
+
+int Compiler::stringConstant(const std::string& value) {
+    auto it = stringIndex.find(value);
+    if (it != stringIndex.end()) {
+        return it->second;
+    }
+    int index = static_cast<int>(chunk.strings.size());
+    chunk.strings.push_back(value);
+    stringIndex[value] = index;
+    return index;
+}
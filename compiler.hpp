@@ -0,0 +1,47 @@
+#ifndef COMPILER_HPP
+#define COMPILER_HPP
+
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GUMLANG {
+
+// Lowers a parsed Program to bytecode for the VM.
+class Compiler {
+public:
+    // Bump whenever the bytecode or the Chunk tables change meaning, so
+    // that cached .gumc files from older builds are compiled again.
+    static constexpr uint32_t version = 1;
+
+    Chunk compile(const Program& program);
+
+private:
+    void compileBlock(const Block& block);
+    void compileStatement(const Stmt& stmt);
+    void compileIf(const Stmt& stmt);
+    void compileFor(const Stmt& stmt);
+    void compileCondition(const Condition& condition, std::vector<int>& falseJumps);
+    void compileExpression(const Expr& expr);
+
+    void threadJumps();
+    void fuseInstructions();
+
+    int emit(OpCode op, int32_t a = 0, int32_t b = 0);
+    void patchJump(int at);
+    int guardTarget(const Stmt& stmt);
+    void patchGuard(int at);
+    int numberConstant(double value);
+    int stringConstant(const std::string& value);
+
+    Chunk chunk;
+    std::unordered_map<uint64_t, int> numberIndex;
+    std::unordered_map<std::string, int> stringIndex;
+};
+
+} // namespace GUMLANG
+
+#endif // COMPILER_HPP
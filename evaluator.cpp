@@ -0,0 +1,124 @@
+#include "evaluator.hpp"
+#include "runtime.hpp"
+#include <iostream>
+using namespace GUMLANG;
+
+void Evaluator::run(const Program& program) {
+    slots.assign(program.slotNames.size(), Variable());
+    defined.assign(program.slotNames.size(), false);
+    slotNames = &program.slotNames;
+
+    executeBlock(program.body);
+}
+
+void Evaluator::executeBlock(const Block& block) {
+    for (const auto& stmt : block) {
+        execute(*stmt);
+    }
+}
+
+void Evaluator::execute(const Stmt& stmt) {
+    switch (stmt.type) {
+        case StmtType::ASSIGN:
+            slots[stmt.slot] = evaluate(*stmt.value);
+            defined[stmt.slot] = true;
+            break;
+        case StmtType::COMPOUND_ASSIGN:
+            if (checkAssigned(stmt)) {
+                Variable right = evaluate(*stmt.value);
+                compoundAssign(stmt.op, slots[stmt.slot], right);
+            }
+            break;
+        case StmtType::INCREMENT:
+            if (checkAssigned(stmt)) stepVariable(slots[stmt.slot], 1);
+            break;
+        case StmtType::DECREMENT:
+            if (checkAssigned(stmt)) stepVariable(slots[stmt.slot], -1);
+            break;
+        case StmtType::PRINT:
+            printValue(evaluate(*stmt.value), out);
+            break;
+        case StmtType::FLUSH:
+            out.flush();
+            break;
+        case StmtType::IF:
+            executeIf(stmt);
+            break;
+        case StmtType::FOR:
+            executeFor(stmt);
+            break;
+        case StmtType::STEP_LOOP:
+            runStepLoop(stmt.cycles, stmt.steps.data(), stmt.steps.size(), slots.data());
+            break;
+    }
+}
+
+bool Evaluator::checkAssigned(const Stmt& stmt) {
+    if (stmt.checked && !defined[stmt.slot]) {
+        std::cerr << "Undefined variable: " << stmt.name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Evaluator::executeIf(const Stmt& stmt) {
+    for (const Branch& branch : stmt.branches) {
+        if (evaluateCondition(*branch.condition)) {
+            executeBlock(branch.body);
+            return;
+        }
+    }
+    if (stmt.hasElse) {
+        executeBlock(stmt.elseBody);
+    }
+}
+
+void Evaluator::executeFor(const Stmt& stmt) {
+    for (int i = 0; i < stmt.cycles; ++i) {
+        executeBlock(stmt.body);
+    }
+}
+
+bool Evaluator::evaluateCondition(const Condition& condition) {
+    switch (condition.type) {
+        case ConditionType::AND:
+            return evaluateCondition(*condition.first) && evaluateCondition(*condition.second);
+        case ConditionType::OR:
+            return evaluateCondition(*condition.first) || evaluateCondition(*condition.second);
+        case ConditionType::COMPARE:
+            break;
+    }
+    Variable left = evaluate(*condition.left);
+    Variable right = evaluate(*condition.right);
+    return compareValues(condition.op, left, right);
+}
+
+Variable Evaluator::evaluate(const Expr& expr) {
+    switch (expr.type) {
+        case ExprType::NUMBER:
+        case ExprType::STRING:
+            return expr.value;
+        case ExprType::VARIABLE:
+            return lookup(expr);
+        case ExprType::RANDOM:
+            return Variable(random.between(expr.minValue, expr.maxValue));
+        case ExprType::BINARY: {
+            Variable left = evaluate(*expr.left);
+            Variable right = evaluate(*expr.right);
+            // The result is built in 'left': numbers directly, strings by
+            // applyBinary, which also reports the errors.
+            if (!numericBinary(expr.op, left, right, left)) applyBinary(expr.op, left, right);
+            return left;
+        }
+    }
+    return Variable(0.0);
+}
+
+Variable Evaluator::lookup(const Expr& expr) {
+    if (expr.checked && !defined[expr.slot]) {
+        std::cerr << "Undefined variable: " << expr.text << std::endl;
+        return Variable(0.0);
+    }
+    if (expr.lastUse) return std::move(slots[expr.slot]);
+    return slots[expr.slot];
+}
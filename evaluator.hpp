@@ -0,0 +1,39 @@
+#ifndef EVALUATOR_HPP
+#define EVALUATOR_HPP
+
+#include "ast.hpp"
+#include "output.hpp"
+#include "random.hpp"
+#include "variable.hpp"
+#include <string>
+#include <vector>
+
+namespace GUMLANG {
+
+// Tree-walking back end: executes a Program produced by the Parser.
+class Evaluator {
+public:
+    explicit Evaluator(OutputSink& out = standardOutput(), uint64_t seed = RandomEngine::randomSeed())
+        : out(out), random(seed) {}
+    void run(const Program& program);
+
+private:
+    void executeBlock(const Block& block);
+    void execute(const Stmt& stmt);
+    bool checkAssigned(const Stmt& stmt);
+    void executeIf(const Stmt& stmt);
+    void executeFor(const Stmt& stmt);
+    bool evaluateCondition(const Condition& condition);
+    Variable evaluate(const Expr& expr);
+    Variable lookup(const Expr& expr);
+
+    OutputSink& out;
+    RandomEngine random;
+    std::vector<Variable> slots;
+    std::vector<bool> defined;
+    const std::vector<std::string>* slotNames = nullptr;
+};
+
+} // namespace GUMLANG
+
+#endif // EVALUATOR_HPP
@@ -1,5 +1,6 @@
 #include "parser.hpp"
 
+#include <fstream>
 #include <string>
 #include <ostream>
 #include <iostream>
@@ -0,0 +1,98 @@
+#ifndef KEYWORDS_HPP
+#define KEYWORDS_HPP
+
+#include "token.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Keyword recognition for Lexer::identifier. The table below is the only
+// place a keyword has to be added; the perfect hash over it is found at
+// compile time, so classifying an identifier costs one hash and at most one
+// comparison.
+
+struct Keyword {
+    std::string_view spelling;
+    TokenType type;
+};
+
+inline constexpr Keyword keywords[] = {
+    {"if", TokenType::TOKEN_IF},
+    {"then", TokenType::TOKEN_THEN},
+    {"else", TokenType::TOKEN_ELSE},
+    {"print", TokenType::TOKEN_PRINT},
+    {"for", TokenType::TOKEN_FOR},
+    {"random", TokenType::TOKEN_RANDOM},
+};
+
+inline constexpr size_t keywordCount = sizeof(keywords) / sizeof(keywords[0]);
+inline constexpr size_t keywordTableSize = 16; // power of two, > keywordCount
+
+static_assert(keywordTableSize > keywordCount, "keyword table is too small");
+
+constexpr uint32_t keywordHash(std::string_view word, uint32_t seed) {
+    uint32_t first = static_cast<unsigned char>(word[0]);
+    uint32_t last = static_cast<unsigned char>(word[word.size() - 1]);
+    return (first * seed + last + static_cast<uint32_t>(word.size()) * 7) & (keywordTableSize - 1);
+}
+
+constexpr bool keywordSeedIsPerfect(uint32_t seed) {
+    bool used[keywordTableSize] = {};
+    for (const Keyword& keyword : keywords) {
+        uint32_t slot = keywordHash(keyword.spelling, seed);
+        if (used[slot]) return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t findKeywordSeed() {
+    for (uint32_t seed = 1; seed < 4096; ++seed) {
+        if (keywordSeedIsPerfect(seed)) return seed;
+    }
+    return 0;
+}
+
+inline constexpr uint32_t keywordSeed = findKeywordSeed();
+static_assert(keywordSeed != 0, "no perfect hash seed for the keyword table; grow keywordTableSize");
+
+constexpr std::array<int8_t, keywordTableSize> buildKeywordTable() {
+    std::array<int8_t, keywordTableSize> table = {};
+    for (auto& entry : table) entry = -1;
+    for (size_t i = 0; i < keywordCount; ++i) {
+        table[keywordHash(keywords[i].spelling, keywordSeed)] = static_cast<int8_t>(i);
+    }
+    return table;
+}
+
+inline constexpr std::array<int8_t, keywordTableSize> keywordTable = buildKeywordTable();
+
+constexpr size_t shortestKeyword() {
+    size_t length = keywords[0].spelling.size();
+    for (const Keyword& keyword : keywords) length = keyword.spelling.size() < length ? keyword.spelling.size() : length;
+    return length;
+}
+
+constexpr size_t longestKeyword() {
+    size_t length = 0;
+    for (const Keyword& keyword : keywords) length = keyword.spelling.size() > length ? keyword.spelling.size() : length;
+    return length;
+}
+
+// TOKEN_IDENTIFIER unless word is a keyword.
+constexpr TokenType classifyKeyword(std::string_view word) {
+    if (word.size() < shortestKeyword() || word.size() > longestKeyword()) {
+        return TokenType::TOKEN_IDENTIFIER;
+    }
+    int8_t index = keywordTable[keywordHash(word, keywordSeed)];
+    if (index >= 0 && keywords[index].spelling == word) {
+        return keywords[index].type;
+    }
+    return TokenType::TOKEN_IDENTIFIER;
+}
+
+static_assert(classifyKeyword("random") == TokenType::TOKEN_RANDOM, "keyword hash is broken");
+static_assert(classifyKeyword("iff") == TokenType::TOKEN_IDENTIFIER, "keyword hash is broken");
+
+#endif // KEYWORDS_HPP
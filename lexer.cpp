@@ -1,9 +1,15 @@
 #include "lexer.hpp"
+#include "keywords.hpp"
 #include <cctype>
 #include <iostream>
 
-Lexer::Lexer(const std::string& source)
-    : source(source), index(0), line(1), column(1), currentChar(source[index]) {}
+static bool isIdentifierChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+Lexer::Lexer(std::string_view source, const ScanKernels& kernels)
+    : source(source), index(0), line(1), column(1), tokenLine(1), tokenColumn(1),
+      currentChar(source.empty() ? '\0' : source[0]), kernels(&kernels) {}
 
 void Lexer::advance() {
     if (currentChar != '\0') {
@@ -21,88 +27,114 @@ void Lexer::advance() {
     }
 }
 
+// Moves to 'target' in one step, updating line and column for everything
+// skipped exactly as the same number of advance() calls would.
+void Lexer::jumpTo(size_t target) {
+    size_t newlines = kernels->countNewlines(source.data(), index, target);
+    if (newlines == 0) {
+        column += static_cast<int>(target - index);
+    } else {
+        size_t lastNewline = target - 1;
+        while (source[lastNewline] != '\n') {
+            lastNewline--;
+        }
+        line += static_cast<int>(newlines);
+        column = static_cast<int>(target - lastNewline);
+    }
+    index = target;
+    currentChar = index < source.size() ? source[index] : '\0';
+}
+
+// jumpTo for a range known not to contain a newline.
+void Lexer::jumpWithinLine(size_t target) {
+    column += static_cast<int>(target - index);
+    index = target;
+    currentChar = index < source.size() ? source[index] : '\0';
+}
+
 void Lexer::skipWhitespace() {
-    while (isspace(currentChar) && currentChar != '\n') {
-        advance();
+    if (isspace(static_cast<unsigned char>(currentChar)) && currentChar != '\n') {
+        jumpWithinLine(kernels->skipBlanks(source.data(), index, source.size()));
     }
 }
 
+// Stops at the newline so the end of the line is still reported.
 void Lexer::skipSingleLineComment() {
-    while (currentChar != '\n' && currentChar != '\0') {
-        advance();
-    }
-    if (currentChar == '\n') {
-        advance();
-    }
+    jumpWithinLine(kernels->findEither(source.data(), index, source.size(), '\n', '\0'));
 }
 
+// Searches for the '/' of the closing '*/' rather than for '*', so banner
+// comments full of asterisks do not stop the scan at every byte.
 void Lexer::skipMultiLineComment() {
-    while (currentChar != '\0') {
-        if (currentChar == '*') {
-            advance();
-            if (currentChar == '/') {
-                advance();
-                break;
-            }
-        } else {
-            advance();
+    if (currentChar == '\0') return;
+
+    size_t position = index + 1;
+    while (true) {
+        position = kernels->findEither(source.data(), position, source.size(), '/', '\0');
+        if (position >= source.size() || source[position] == '\0') {
+            jumpTo(position);
+            return;
+        }
+        if (source[position - 1] == '*') {
+            jumpTo(position + 1);
+            return;
         }
+        position++;
     }
 }
 
 Token Lexer::identifier() {
-    std::string value;
-    while (isalnum(currentChar) || currentChar == '_') {
-        value += currentChar;
-        advance();
-    }
-    if (value == "if") return makeToken(TokenType::TOKEN_IF, value);
-    if (value == "then") return makeToken(TokenType::TOKEN_THEN, value);
-    if (value == "else") {
-        skipWhitespace();
-        if (currentChar == 'i') {
-            advance();
-            if (currentChar == 'f') {
+    size_t start = index;
+    jumpWithinLine(kernels->skipIdentifier(source.data(), index, source.size()));
+    std::string_view value = source.substr(start, index - start);
+
+    TokenType type = classifyKeyword(value);
+    if (type == TokenType::TOKEN_ELSE) {
+        // 'else if' is a single token; look past the spaces for a whole 'if'.
+        size_t next = index;
+        while (next < source.size() && (source[next] == ' ' || source[next] == '\t' || source[next] == '\r')) {
+            next++;
+        }
+        bool elseIf = source.substr(next, 2) == "if" &&
+                      (next + 2 >= source.size() || !isIdentifierChar(source[next + 2]));
+        if (elseIf) {
+            while (index < next + 2) {
                 advance();
-                return makeToken(TokenType::TOKEN_ELSEIF, "else if");
             }
+            return makeToken(TokenType::TOKEN_ELSEIF, source.substr(start, index - start));
         }
-        return makeToken(TokenType::TOKEN_ELSE, value);
     }
-    if (value == "print") return makeToken(TokenType::TOKEN_PRINT, value);
-    if (value == "for") return makeToken(TokenType::TOKEN_FOR, value);
-    if (value == "random") return makeToken(TokenType::TOKEN_RANDOM, value);
-    return makeToken(TokenType::TOKEN_IDENTIFIER, value);
+    return makeToken(type, value);
 }
 
 Token Lexer::number() {
-    std::string value;
-    while (isdigit(currentChar) || currentChar == '.') {
-        value += currentChar;
+    size_t start = index;
+    while (isdigit(static_cast<unsigned char>(currentChar)) || currentChar == '.') {
         advance();
     }
-    return makeToken(TokenType::TOKEN_NUMBER, value);
+    return makeToken(TokenType::TOKEN_NUMBER, source.substr(start, index - start));
 }
 
 Token Lexer::string() {
-    std::string value;
     advance(); // Skip the opening quote
-    while (currentChar != '"' && currentChar != '\0') {
-        value += currentChar;
-        advance();
-    }
+    size_t start = index;
+    jumpTo(kernels->findEither(source.data(), index, source.size(), '"', '\0'));
+    std::string_view value = source.substr(start, index - start);
     advance(); // Skip the closing quote
     return makeToken(TokenType::TOKEN_STRING, value);
 }
 
-Token Lexer::makeToken(TokenType type, const std::string& value) {
-    return {type, value, line, column};
+Token Lexer::makeToken(TokenType type, std::string_view value) {
+    return {type, value, tokenLine, tokenColumn};
 }
 
 Token Lexer::getNextToken() {
     skipWhitespace();
 
     while (true) {
+        tokenLine = line;
+        tokenColumn = column;
+
         if (currentChar == '\0') return makeToken(TokenType::TOKEN_EOF, "");
 
         if (currentChar == '\n') {
@@ -121,13 +153,16 @@ Token Lexer::getNextToken() {
                 skipMultiLineComment();
                 skipWhitespace();
                 continue;
+            } else if (currentChar == '=') {
+                advance();
+                return makeToken(TokenType::TOKEN_OPERATOR_SLASHEQUAL, "/=");
             }
             return makeToken(TokenType::TOKEN_OPERATOR, "/");
         }
 
-        if (isalpha(currentChar) || currentChar == '_') return identifier();
+        if (isalpha(static_cast<unsigned char>(currentChar)) || currentChar == '_') return identifier();
 
-        if (isdigit(currentChar)) return number();
+        if (isdigit(static_cast<unsigned char>(currentChar))) return number();
 
         if (currentChar == '"') return string();
 
@@ -162,14 +197,34 @@ Token Lexer::getNextToken() {
 
         if (currentChar == '>') {
             advance();
+            if (currentChar == '=') {
+                advance();
+                return makeToken(TokenType::TOKEN_OPERATOR, ">=");
+            }
             return makeToken(TokenType::TOKEN_OPERATOR, ">");
         }
 
         if (currentChar == '<') {
             advance();
+            if (currentChar == '=') {
+                advance();
+                return makeToken(TokenType::TOKEN_OPERATOR, "<=");
+            }
             return makeToken(TokenType::TOKEN_OPERATOR, "<");
         }
 
+        if (currentChar == '&' && index + 1 < source.size() && source[index + 1] == '&') {
+            advance();
+            advance();
+            return makeToken(TokenType::TOKEN_AND, "&&");
+        }
+
+        if (currentChar == '|' && index + 1 < source.size() && source[index + 1] == '|') {
+            advance();
+            advance();
+            return makeToken(TokenType::TOKEN_OR, "||");
+        }
+
         if (currentChar == '!') {
             advance();
             if (currentChar == '=') {
@@ -230,7 +285,8 @@ Token Lexer::getNextToken() {
         }
 
         std::cerr << "Unexpected character: " << currentChar << " at line " << line << ", column " << column << std::endl;
+        size_t start = index;
         advance();
-        return makeToken(TokenType::TOKEN_UNKNOWN, std::string(1, currentChar));
+        return makeToken(TokenType::TOKEN_UNKNOWN, source.substr(start, 1));
     }
 }
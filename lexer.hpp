@@ -1,32 +1,35 @@
 #ifndef LEXER_HPP
 #define LEXER_HPP
 
-#include <string>
-#include <vector>
-#include <cctype>
-#include <iostream>
+#include <string_view>
+#include "scan.hpp"
 #include "token.hpp"
 
 class Lexer {
 public:
-    Lexer(const std::string& source);
+    Lexer(std::string_view source, const ScanKernels& kernels = defaultScanKernels());
     Token getNextToken();
 
 private:
-    std::string source;
+    std::string_view source;
     size_t index;
     int line;
     int column;
+    int tokenLine;
+    int tokenColumn;
     char currentChar;
+    const ScanKernels* kernels;
 
     void advance();
+    void jumpTo(size_t target);
+    void jumpWithinLine(size_t target);
     void skipWhitespace();
     void skipSingleLineComment();
     void skipMultiLineComment();
     Token identifier();
     Token number();
     Token string();
-    Token makeToken(TokenType type, const std::string& value);
+    Token makeToken(TokenType type, std::string_view value);
 };
 
 #endif // LEXER_HPP
@@ -1,19 +1,95 @@
 #include <iostream>
 #include <string>
+#include "optimizer.hpp"
 #include "parser.hpp"
 
 using namespace GUMLANG;
 
-int main()
+static void printUsage()
 {
-    // std::cout << "Enter source file directory." << std::endl;
-    // std::string input;
-    // std::cin >> input;
-    
-    std::string input = "/Users/zacharybunch/Documents/GUMLANG/GUMLANG/hello.gum";
+    std::cerr << "Usage: gum [--engine=vm|tree] [--opt-level=0-" << Optimizer::maxLevel << "] [--dump-opt] [--stats] [--line-buffered] [--seed=N] [--no-cache] [--cache-dir=DIR] [--emit-cpp=FILE] <file.gum>" << std::endl;
+}
 
-    Parser parser(input);
-    parser.InterpretFile();
+int main(int argc, char* argv[])
+{
+    Options options;
+    std::string input;
 
-    return 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--engine=vm")
+        {
+            options.engine = Engine::VM;
+        }
+        else if (arg == "--engine=tree")
+        {
+            options.engine = Engine::TREE;
+        }
+        else if (arg.rfind("--opt-level=", 0) == 0)
+        {
+            std::string level = arg.substr(12);
+            if (level.size() != 1 || level[0] < '0' || level[0] - '0' > Optimizer::maxLevel)
+            {
+                std::cerr << "Invalid optimization level: " << level << std::endl;
+                printUsage();
+                return 1;
+            }
+            options.optLevel = level[0] - '0';
+        }
+        else if (arg == "--dump-opt")
+        {
+            options.dumpOptimizations = true;
+        }
+        else if (arg == "--stats")
+        {
+            options.vmStats = true;
+        }
+        else if (arg == "--line-buffered")
+        {
+            options.lineBuffered = true;
+        }
+        else if (arg.rfind("--seed=", 0) == 0)
+        {
+            std::string seed = arg.substr(7);
+            if (seed.empty() || seed.size() > 19 || seed.find_first_not_of("0123456789") != std::string::npos)
+            {
+                std::cerr << "Invalid seed: " << seed << std::endl;
+                printUsage();
+                return 1;
+            }
+            options.seed = std::stoull(seed);
+        }
+        else if (arg == "--no-cache")
+        {
+            options.useCache = false;
+        }
+        else if (arg.rfind("--cache-dir=", 0) == 0 && arg.size() > 12)
+        {
+            options.cacheDir = arg.substr(12);
+        }
+        else if (arg.rfind("--emit-cpp=", 0) == 0 && arg.size() > 11)
+        {
+            options.emitCpp = arg.substr(11);
+        }
+        else if (arg.rfind("--", 0) == 0 || !input.empty())
+        {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            input = arg;
+        }
+    }
+
+    if (input.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    Parser parser(input);
+    return parser.InterpretFile(options) ? 0 : 1;
 }
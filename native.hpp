@@ -0,0 +1,133 @@
+#ifndef NATIVE_HPP
+#define NATIVE_HPP
+
+#include "output.hpp"
+#include "random.hpp"
+#include "runtime.hpp"
+#include "variable.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace GUMLANG {
+namespace native {
+
+// Runtime support for programs translated to C++ by the Transpiler. A
+// translated program keeps numbers in double locals and everything else
+// in Variables, and calls these helpers wherever the interpreters would
+// report an error, print, or draw a random number; the helpers go through
+// the same runtime.hpp functions as the engines, so the program prints
+// exactly what 'gum' prints for the same source.
+//
+// Build a translated program together with the runtime sources:
+//     g++ -std=c++17 -O2 -I<gum> program.cpp <gum>/runtime.cpp <gum>/variable.cpp
+//         <gum>/output.cpp <gum>/random.cpp -o program
+class Runtime {
+public:
+    // Accepts the interpreter's --seed=N and --line-buffered.
+    Runtime(int argc, char* argv[]) : out(standardOutput()), engine(seedFrom(argc, argv)) {}
+
+    void print(double value) { printValue(Variable(value), out); }
+    void print(const Variable& value) { printValue(value, out); }
+    void flush() { out.flush(); }
+    double random(int minValue, int maxValue) { return static_cast<double>(engine.between(minValue, maxValue)); }
+
+private:
+    static uint64_t seedFrom(int argc, char* argv[]) {
+        uint64_t seed = RandomEngine::randomSeed();
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            std::string digits = arg.rfind("--seed=", 0) == 0 ? arg.substr(7) : "";
+            if (arg == "--line-buffered") {
+                standardOutput().setMode(FileSink::Mode::LINE);
+            } else if (!digits.empty() && digits.size() <= 19 &&
+                       digits.find_first_not_of("0123456789") == std::string::npos) {
+                seed = std::stoull(digits);
+            } else {
+                std::cerr << "Usage: " << argv[0] << " [--line-buffered] [--seed=N]" << std::endl;
+                std::exit(1);
+            }
+        }
+        return seed;
+    }
+
+    OutputSink& out;
+    RandomEngine engine;
+};
+
+inline Variable value(double number) {
+    return Variable::number(number);
+}
+
+// A read of a variable that has not been assigned yet.
+inline double undefined(const char* name) {
+    std::cerr << "Undefined variable: " << name << std::endl;
+    return 0.0;
+}
+
+inline Variable undefinedValue(const char* name) {
+    return Variable(undefined(name));
+}
+
+// Division and '/=' on numbers; dividing by zero reports the error and
+// gives 0 or leaves the target alone.
+inline double divide(double left, double right) {
+    if (right == 0) return binaryOperation('/', Variable(left), Variable(right)).toNumber();
+    return left / right;
+}
+
+inline void divideAssign(double& target, double right) {
+    if (right == 0) {
+        Variable copy(target);
+        compoundAssign('/', copy, Variable(right));
+    } else {
+        target /= right;
+    }
+}
+
+// Operations with at least one operand that is not known to be a number.
+// '-', '*' and '/' always produce a number.
+inline Variable binary(char op, Variable left, const Variable& right) {
+    applyBinary(op, left, right);
+    return left;
+}
+
+inline double arithmetic(char op, const Variable& left, const Variable& right) {
+    return binaryOperation(op, left, right).toNumber();
+}
+
+// A compound assignment to a number whose right-hand side may be a string.
+inline void compoundAssignNumber(char op, double& target, const Variable& right) {
+    Variable copy(target);
+    compoundAssign(op, copy, right);
+    target = copy.toNumber();
+}
+
+// The closed form of a STEP_LOOP, as in runStepLoop: a target qualifies
+// when it is a whole number and stays below 2^53 however far the loop
+// moves it ('reach' is cycles times the total size of its steps).
+inline bool exactSteps(double target, double reach) {
+    return std::trunc(target) == target && std::fabs(target) + reach < 9007199254740992.0;
+}
+
+inline bool exactSteps(const Variable& target, double reach) {
+    return target.isNumber() && exactSteps(target.toNumber(), reach);
+}
+
+inline void addSteps(double& target, double total) {
+    target += total;
+}
+
+inline void addSteps(Variable& target, double total) {
+    if (target.type == VariableType::INTEGER) {
+        target.integerValue += static_cast<int64_t>(total);
+    } else {
+        target.numberValue += total;
+    }
+}
+
+} // namespace native
+} // namespace GUMLANG
+
+#endif // NATIVE_HPP
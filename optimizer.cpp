@@ -0,0 +1,731 @@
+#include "optimizer.hpp"
+#include "runtime.hpp"
+#include <cmath>
+#include <sstream>
+using namespace GUMLANG;
+
+static int precedence(char op) {
+    return op == '*' || op == '/' ? 2 : 1;
+}
+
+static const char* compareSpelling(CompareOp op) {
+    switch (op) {
+        case CompareOp::EQUAL: return "==";
+        case CompareOp::NOT_EQUAL: return "!=";
+        case CompareOp::LESS: return "<";
+        case CompareOp::GREATER: return ">";
+        case CompareOp::LESS_EQUAL: return "<=";
+        case CompareOp::GREATER_EQUAL: return ">=";
+    }
+    return "?";
+}
+
+// Source-like text for the optimization log, parenthesized only where the
+// grouping differs from what the parser would produce.
+static void render(std::ostream& out, const Expr& expr) {
+    switch (expr.type) {
+        case ExprType::NUMBER:
+            out << expr.number;
+            break;
+        case ExprType::STRING:
+            out << '"' << expr.text << '"';
+            break;
+        case ExprType::VARIABLE:
+            out << expr.text;
+            break;
+        case ExprType::RANDOM:
+            out << "random " << expr.minValue << ' ' << expr.maxValue;
+            break;
+        case ExprType::BINARY: {
+            auto operand = [&](const Expr& side, bool right) {
+                bool group = side.type == ExprType::BINARY &&
+                             (precedence(side.op) < precedence(expr.op) ||
+                              (right && precedence(side.op) == precedence(expr.op)));
+                if (group) out << '(';
+                render(out, side);
+                if (group) out << ')';
+            };
+            operand(*expr.left, false);
+            out << ' ' << expr.op << ' ';
+            operand(*expr.right, true);
+            break;
+        }
+    }
+}
+
+static void render(std::ostream& out, const Condition& condition) {
+    switch (condition.type) {
+        case ConditionType::COMPARE:
+            render(out, *condition.left);
+            out << ' ' << compareSpelling(condition.op) << ' ';
+            render(out, *condition.right);
+            break;
+        case ConditionType::AND:
+        case ConditionType::OR:
+            render(out, *condition.first);
+            out << (condition.type == ConditionType::AND ? " && " : " || ");
+            render(out, *condition.second);
+            break;
+    }
+}
+
+template <typename Node>
+static std::string describe(const Node& node) {
+    std::ostringstream out;
+    render(out, node);
+    return out.str();
+}
+
+static int conditionLine(const Condition& condition) {
+    return condition.type == ConditionType::COMPARE ? condition.left->line : conditionLine(*condition.first);
+}
+
+static bool isLiteral(const Expr& expr) {
+    return expr.type == ExprType::NUMBER || expr.type == ExprType::STRING;
+}
+
+static bool isNumber(const Expr& expr, double value) {
+    return expr.type == ExprType::NUMBER && expr.number == value;
+}
+
+static bool sameExpression(const Expr& a, const Expr& b) {
+    if (a.type != b.type) return false;
+    switch (a.type) {
+        case ExprType::NUMBER:
+            return a.number == b.number && std::signbit(a.number) == std::signbit(b.number);
+        case ExprType::STRING:
+            return a.text == b.text;
+        case ExprType::VARIABLE:
+            return a.slot == b.slot && a.checked == b.checked;
+        case ExprType::RANDOM:
+            return false;
+        case ExprType::BINARY:
+            return a.op == b.op && sameExpression(*a.left, *b.left) && sameExpression(*a.right, *b.right);
+    }
+    return false;
+}
+
+static bool readsAny(const Expr& expr, const std::vector<bool>& written) {
+    switch (expr.type) {
+        case ExprType::VARIABLE:
+            return expr.slot < static_cast<int>(written.size()) && written[expr.slot];
+        case ExprType::BINARY:
+            return readsAny(*expr.left, written) || readsAny(*expr.right, written);
+        default:
+            return false;
+    }
+}
+
+static void collectReads(Expr& expr, int slot, std::vector<Expr*>& reads) {
+    if (expr.type == ExprType::VARIABLE && expr.slot == slot) {
+        reads.push_back(&expr);
+    } else if (expr.type == ExprType::BINARY) {
+        collectReads(*expr.left, slot, reads);
+        collectReads(*expr.right, slot, reads);
+    }
+}
+
+// An assignment whose value reads its own target once, as 's = s + x'
+// does, may take the target's value instead of copying it, since nothing
+// reads the slot again before the assignment overwrites it. A string
+// built this way is appended to in place rather than copied every time.
+static void markLastUses(Block& block) {
+    for (auto& stmt : block) {
+        switch (stmt->type) {
+            case StmtType::ASSIGN: {
+                std::vector<Expr*> reads;
+                collectReads(*stmt->value, stmt->slot, reads);
+                if (reads.size() == 1 && !reads[0]->checked) reads[0]->lastUse = true;
+                break;
+            }
+            case StmtType::IF:
+                for (Branch& branch : stmt->branches) {
+                    markLastUses(branch.body);
+                }
+                markLastUses(stmt->elseBody);
+                break;
+            case StmtType::FOR:
+                markLastUses(stmt->body);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void markWrite(int slot, std::vector<bool>& written) {
+    if (slot >= static_cast<int>(written.size())) written.resize(slot + 1, false);
+    written[slot] = true;
+}
+
+static void collectWrites(const Block& block, std::vector<bool>& written);
+
+static void collectWrites(const Stmt& stmt, std::vector<bool>& written) {
+    switch (stmt.type) {
+        case StmtType::ASSIGN:
+        case StmtType::COMPOUND_ASSIGN:
+        case StmtType::INCREMENT:
+        case StmtType::DECREMENT:
+            markWrite(stmt.slot, written);
+            break;
+        case StmtType::PRINT:
+        case StmtType::FLUSH:
+            break;
+        case StmtType::IF:
+            for (const Branch& branch : stmt.branches) {
+                collectWrites(branch.body, written);
+            }
+            collectWrites(stmt.elseBody, written);
+            break;
+        case StmtType::FOR:
+            collectWrites(stmt.body, written);
+            break;
+        case StmtType::STEP_LOOP:
+            for (const LoopStep& step : stmt.steps) {
+                markWrite(step.slot, written);
+            }
+            break;
+    }
+}
+
+static void collectWrites(const Block& block, std::vector<bool>& written) {
+    for (const auto& stmt : block) {
+        collectWrites(*stmt, written);
+    }
+}
+
+static void collectConditionSites(Condition& condition, std::vector<std::unique_ptr<Expr>*>& sites) {
+    if (condition.type == ConditionType::COMPARE) {
+        sites.push_back(&condition.left);
+        sites.push_back(&condition.right);
+    } else {
+        collectConditionSites(*condition.first, sites);
+        collectConditionSites(*condition.second, sites);
+    }
+}
+
+// Expressions a statement evaluates before it writes any variable: its
+// value, or every condition of an if (conditions never run after a body).
+static void collectStatementSites(Stmt& stmt, std::vector<std::unique_ptr<Expr>*>& sites) {
+    switch (stmt.type) {
+        case StmtType::ASSIGN:
+        case StmtType::COMPOUND_ASSIGN:
+        case StmtType::PRINT:
+            sites.push_back(&stmt.value);
+            break;
+        case StmtType::IF:
+            for (Branch& branch : stmt.branches) {
+                collectConditionSites(*branch.condition, sites);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Every binary sub-expression of 'site', parents before their operands.
+static void collectSubexpressions(std::unique_ptr<Expr>& site, std::vector<std::unique_ptr<Expr>*>& out) {
+    if (site->type != ExprType::BINARY) return;
+    out.push_back(&site);
+    collectSubexpressions(site->left, out);
+    collectSubexpressions(site->right, out);
+}
+
+// A read of the temporary assigned by 'temp', in place of 'at'.
+static std::unique_ptr<Expr> loadTemporary(const Stmt& temp, const Expr& at) {
+    auto load = std::make_unique<Expr>();
+    load->type = ExprType::VARIABLE;
+    load->line = at.line;
+    load->column = at.column;
+    load->text = temp.name;
+    load->slot = temp.slot;
+    return load;
+}
+
+Optimizer::Optimizer(int level, std::ostream* log) : level(level), log(log) {}
+
+void Optimizer::optimize(Program& program) {
+    if (level < 1) return;
+
+    findNumericSlots(program);
+    slotNames = &program.slotNames;
+    optimizeBlock(program.body);
+    if (level >= 2) moveInvariants(program.body, false);
+    markLastUses(program.body);
+}
+
+void Optimizer::optimizeBlock(Block& block) {
+    Block optimized;
+    optimized.reserve(block.size());
+    for (auto& stmt : block) {
+        optimizeStatement(std::move(stmt), optimized);
+    }
+    block = std::move(optimized);
+}
+
+// Appends the optimized form of 'stmt' to 'out': usually the statement
+// itself, but an if with constant conditions becomes the body that always
+// runs, or nothing at all.
+void Optimizer::optimizeStatement(std::unique_ptr<Stmt> stmt, Block& out) {
+    switch (stmt->type) {
+        case StmtType::ASSIGN:
+        case StmtType::COMPOUND_ASSIGN:
+        case StmtType::PRINT:
+            optimizeValue(stmt->value, stmt->line);
+            break;
+        case StmtType::INCREMENT:
+        case StmtType::DECREMENT:
+        case StmtType::FLUSH:
+            break;
+        case StmtType::IF:
+            optimizeIf(std::move(stmt), out);
+            return;
+        case StmtType::FOR:
+            optimizeBlock(stmt->body);
+            if (level >= 2) reduceLoop(*stmt);
+            break;
+        case StmtType::STEP_LOOP:
+            break;
+    }
+    out.push_back(std::move(stmt));
+}
+
+void Optimizer::optimizeIf(std::unique_ptr<Stmt> stmt, Block& out) {
+    std::vector<Branch> kept;
+    for (Branch& branch : stmt->branches) {
+        int line = conditionLine(*branch.condition);
+        std::string before = log ? describe(*branch.condition) : std::string();
+
+        Truth truth = foldCondition(branch.condition);
+        if (log && truth == Truth::UNKNOWN && describe(*branch.condition) != before) {
+            *log << "line " << line << ": condition " << before << " => " << describe(*branch.condition) << '\n';
+        }
+
+        if (truth == Truth::ALWAYS_FALSE) {
+            if (log) *log << "line " << line << ": removed branch, " << before << " is always false\n";
+            continue;
+        }
+        if (truth == Truth::ALWAYS_TRUE) {
+            // Nothing after this branch can run; it becomes the else.
+            if (log) *log << "line " << line << ": " << before << " is always true, later branches removed\n";
+            stmt->elseBody = std::move(branch.body);
+            stmt->hasElse = true;
+            break;
+        }
+        kept.push_back(std::move(branch));
+    }
+    stmt->branches = std::move(kept);
+
+    for (Branch& branch : stmt->branches) {
+        optimizeBlock(branch.body);
+    }
+    if (stmt->hasElse) {
+        optimizeBlock(stmt->elseBody);
+    }
+
+    if (stmt->branches.empty()) {
+        for (auto& inner : stmt->elseBody) {
+            out.push_back(std::move(inner));
+        }
+        return;
+    }
+    out.push_back(std::move(stmt));
+}
+
+// A loop whose body only adds constants to variables that always hold
+// numbers becomes a STEP_LOOP, which runStepLoop applies in one step.
+// Bodies with anything else (print, if, random, assignments, nested loops)
+// or with targets that may be unassigned keep running normally.
+void Optimizer::reduceLoop(Stmt& loop) {
+    std::vector<LoopStep> steps;
+    for (const auto& stmt : loop.body) {
+        if (stmt->checked || (stmt->slot >= 0 && !numericSlots[stmt->slot])) return;
+
+        switch (stmt->type) {
+            case StmtType::INCREMENT:
+            case StmtType::DECREMENT:
+                steps.push_back({stmt->slot, stmt->type, 0, 0.0});
+                break;
+            case StmtType::COMPOUND_ASSIGN:
+                if ((stmt->op != '+' && stmt->op != '-') || stmt->value->type != ExprType::NUMBER) return;
+                steps.push_back({stmt->slot, stmt->type, stmt->op, stmt->value->number});
+                break;
+            default:
+                return;
+        }
+    }
+
+    if (log) *log << "line " << loop.line << ": for " << loop.cycles << " reduced to closed form\n";
+    loop.type = StmtType::STEP_LOOP;
+    loop.steps = std::move(steps);
+    loop.body.clear();
+}
+
+void Optimizer::optimizeValue(std::unique_ptr<Expr>& value, int line) {
+    if (!log) {
+        foldExpression(value);
+        return;
+    }
+
+    std::string before = describe(*value);
+    foldExpression(value);
+    std::string after = describe(*value);
+    if (after != before) {
+        *log << "line " << line << ": " << before << " => " << after << '\n';
+    }
+}
+
+// Folds both operands of every comparison and drops constant operands of
+// '&&' and '||'. Returns the value of the whole condition when it no longer
+// depends on anything evaluated at run time.
+Optimizer::Truth Optimizer::foldCondition(std::unique_ptr<Condition>& condition) {
+    if (condition->type == ConditionType::COMPARE) {
+        foldExpression(condition->left);
+        foldExpression(condition->right);
+
+        const Expr& left = *condition->left;
+        const Expr& right = *condition->right;
+        if (!isLiteral(left) || left.type != right.type) return Truth::UNKNOWN;
+        if (left.type == ExprType::STRING && condition->op != CompareOp::EQUAL &&
+            condition->op != CompareOp::NOT_EQUAL) {
+            return Truth::UNKNOWN; // reported as unsupported at run time
+        }
+        bool holds = compareValues(condition->op, left.value, right.value);
+        return holds ? Truth::ALWAYS_TRUE : Truth::ALWAYS_FALSE;
+    }
+
+    Truth first = foldCondition(condition->first);
+    Truth second = foldCondition(condition->second);
+
+    // The operand that decides the result on its own, and the one that
+    // leaves the other operand to decide it.
+    bool isAnd = condition->type == ConditionType::AND;
+    Truth decisive = isAnd ? Truth::ALWAYS_FALSE : Truth::ALWAYS_TRUE;
+    Truth neutral = isAnd ? Truth::ALWAYS_TRUE : Truth::ALWAYS_FALSE;
+
+    if (first == decisive) return decisive;
+    if (first == neutral) {
+        condition = std::move(condition->second);
+        return second;
+    }
+    if (second == neutral) {
+        // 'first' still runs, so only a neutral right operand can go.
+        condition = std::move(condition->first);
+        return first;
+    }
+    return Truth::UNKNOWN;
+}
+
+void Optimizer::foldExpression(std::unique_ptr<Expr>& expr) {
+    if (expr->type != ExprType::BINARY) return;
+
+    foldExpression(expr->left);
+    foldExpression(expr->right);
+
+    const Expr& left = *expr->left;
+    const Expr& right = *expr->right;
+    if (isLiteral(left) && isLiteral(right)) {
+        // Only fold what cannot print an error: '+' is the one operator
+        // defined for strings, and division by zero is reported when run.
+        bool strings = left.type == ExprType::STRING || right.type == ExprType::STRING;
+        bool safe = strings ? expr->op == '+' : !(expr->op == '/' && right.number == 0);
+        if (safe) {
+            Variable result = binaryOperation(expr->op, left.value, right.value);
+            auto folded = std::make_unique<Expr>();
+            folded->line = expr->line;
+            folded->column = expr->column;
+            if (result.isNumber()) {
+                folded->type = ExprType::NUMBER;
+                folded->number = result.toNumber();
+                folded->value = Variable::number(folded->number);
+            } else {
+                folded->type = ExprType::STRING;
+                folded->text = result.stringValue();
+                folded->value = std::move(result);
+            }
+            expr = std::move(folded);
+            return;
+        }
+    }
+
+    applyIdentity(expr);
+}
+
+// 'x * 1', '1 * x', 'x / 1', 'x + 0', '0 + x' and 'x - 0' become 'x' when
+// x is always a number; for a string, '+ 0' would append "0".
+bool Optimizer::applyIdentity(std::unique_ptr<Expr>& expr) {
+    std::unique_ptr<Expr>* keep = nullptr;
+    switch (expr->op) {
+        case '+':
+            if (isNumber(*expr->right, 0) && isNumeric(*expr->left)) {
+                keep = &expr->left;
+            } else if (isNumber(*expr->left, 0) && isNumeric(*expr->right)) {
+                keep = &expr->right;
+            }
+            break;
+        case '-':
+            if (isNumber(*expr->right, 0) && isNumeric(*expr->left)) keep = &expr->left;
+            break;
+        case '*':
+            if (isNumber(*expr->right, 1) && isNumeric(*expr->left)) {
+                keep = &expr->left;
+            } else if (isNumber(*expr->left, 1) && isNumeric(*expr->right)) {
+                keep = &expr->right;
+            }
+            break;
+        case '/':
+            if (isNumber(*expr->right, 1) && isNumeric(*expr->left)) keep = &expr->left;
+            break;
+    }
+    if (!keep) return false;
+
+    std::unique_ptr<Expr> operand = std::move(*keep);
+    expr = std::move(operand);
+    return true;
+}
+
+// Runs after the other rewrites, outermost loops first, so an expression
+// leaves every loop it does not depend on.
+void Optimizer::moveInvariants(Block& block, bool inLoop) {
+    Block moved;
+    moved.reserve(block.size());
+    for (auto& stmt : block) {
+        if (stmt->type == StmtType::FOR && stmt->cycles > 1) {
+            hoistInvariants(*stmt, moved);
+        }
+        moved.push_back(std::move(stmt));
+    }
+    block = std::move(moved);
+
+    if (inLoop) {
+        eliminateCommonSubexpressions(block);
+    }
+
+    for (auto& stmt : block) {
+        if (stmt->type == StmtType::IF) {
+            for (Branch& branch : stmt->branches) {
+                moveInvariants(branch.body, inLoop);
+            }
+            moveInvariants(stmt->elseBody, inLoop);
+        } else if (stmt->type == StmtType::FOR) {
+            moveInvariants(stmt->body, true);
+        }
+    }
+}
+
+// Computes every pure expression in the loop that reads nothing the loop
+// writes into a temporary assigned just before the loop. Identical
+// expressions share one temporary.
+void Optimizer::hoistInvariants(Stmt& loop, Block& out) {
+    std::vector<bool> written;
+    collectWrites(loop.body, written);
+
+    Block hoisted;
+    hoistFromBlock(loop.body, written, hoisted, loop);
+    for (auto& stmt : hoisted) {
+        out.push_back(std::move(stmt));
+    }
+}
+
+void Optimizer::hoistFromBlock(Block& block, const std::vector<bool>& written, Block& hoisted, const Stmt& loop) {
+    for (auto& stmt : block) {
+        std::vector<std::unique_ptr<Expr>*> sites;
+        collectStatementSites(*stmt, sites);
+        for (std::unique_ptr<Expr>* site : sites) {
+            hoistFromExpression(*site, written, hoisted, loop);
+        }
+
+        if (stmt->type == StmtType::IF) {
+            for (Branch& branch : stmt->branches) {
+                hoistFromBlock(branch.body, written, hoisted, loop);
+            }
+            hoistFromBlock(stmt->elseBody, written, hoisted, loop);
+        } else if (stmt->type == StmtType::FOR) {
+            hoistFromBlock(stmt->body, written, hoisted, loop);
+        }
+    }
+}
+
+void Optimizer::hoistFromExpression(std::unique_ptr<Expr>& site, const std::vector<bool>& written, Block& hoisted,
+                                    const Stmt& loop) {
+    if (site->type != ExprType::BINARY) return;
+    if (!isPure(*site) || readsAny(*site, written)) {
+        hoistFromExpression(site->left, written, hoisted, loop);
+        hoistFromExpression(site->right, written, hoisted, loop);
+        return;
+    }
+
+    for (const auto& temp : hoisted) {
+        if (sameExpression(*temp->value, *site)) {
+            site = loadTemporary(*temp, *site);
+            return;
+        }
+    }
+
+    std::string text = log ? describe(*site) : std::string();
+    hoisted.push_back(makeTemporary(site));
+    if (log) {
+        *log << "line " << loop.line << ": " << text << " does not change in for " << loop.cycles
+             << ", computed once as " << hoisted.back()->name << '\n';
+    }
+}
+
+// Within one straight-line block, an expression evaluated again before any
+// variable it reads is written is computed once into a temporary placed
+// before the statement that first needs it.
+void Optimizer::eliminateCommonSubexpressions(Block& block) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        struct Occurrence {
+            size_t statement;
+            std::unique_ptr<Expr>* site;
+        };
+        std::vector<Occurrence> occurrences;
+        std::vector<std::vector<bool>> writes(block.size());
+        for (size_t k = 0; k < block.size(); ++k) {
+            std::vector<std::unique_ptr<Expr>*> sites, subexpressions;
+            collectStatementSites(*block[k], sites);
+            for (std::unique_ptr<Expr>* site : sites) {
+                collectSubexpressions(*site, subexpressions);
+            }
+            for (std::unique_ptr<Expr>* site : subexpressions) {
+                occurrences.push_back({k, site});
+            }
+            collectWrites(*block[k], writes[k]);
+        }
+
+        for (size_t a = 0; a < occurrences.size() && !changed; ++a) {
+            const Expr& first = **occurrences[a].site;
+            if (!isPure(first)) continue;
+
+            std::vector<size_t> matches;
+            size_t checkedUpTo = occurrences[a].statement;
+            for (size_t b = a + 1; b < occurrences.size(); ++b) {
+                bool killed = false;
+                for (; checkedUpTo < occurrences[b].statement; ++checkedUpTo) {
+                    killed = killed || readsAny(first, writes[checkedUpTo]);
+                }
+                if (killed) break;
+                if (sameExpression(first, **occurrences[b].site)) matches.push_back(b);
+            }
+            if (matches.empty()) continue;
+
+            std::string text = log ? describe(first) : std::string();
+            size_t statement = occurrences[a].statement;
+            int line = block[statement]->line;
+            std::unique_ptr<Stmt> temp = makeTemporary(*occurrences[a].site);
+            for (size_t b : matches) {
+                std::unique_ptr<Expr>& site = *occurrences[b].site;
+                site = loadTemporary(*temp, *site);
+            }
+            if (log) {
+                *log << "line " << line << ": " << text << " repeated " << matches.size() + 1
+                     << " times, computed once as " << temp->name << '\n';
+            }
+            block.insert(block.begin() + statement, std::move(temp));
+            changed = true;
+        }
+    }
+}
+
+// Moves the expression at 'site' into an assignment to a new temporary
+// slot, leaving a load of that slot in its place.
+std::unique_ptr<Stmt> Optimizer::makeTemporary(std::unique_ptr<Expr>& site) {
+    int slot = static_cast<int>(slotNames->size());
+    slotNames->push_back("$t" + std::to_string(slot));
+    numericSlots.push_back(isNumeric(*site));
+
+    auto temp = std::make_unique<Stmt>();
+    temp->type = StmtType::ASSIGN;
+    temp->line = site->line;
+    temp->column = site->column;
+    temp->name = slotNames->back();
+    temp->slot = slot;
+
+    std::unique_ptr<Expr> load = loadTemporary(*temp, *site);
+    temp->value = std::move(site);
+    site = std::move(load);
+    return temp;
+}
+
+// Evaluating a pure expression has no effect besides its value: no random
+// numbers, no reads that may report an undefined variable, and no
+// operation that can report a type error or a division by zero.
+bool Optimizer::isPure(const Expr& expr) const {
+    switch (expr.type) {
+        case ExprType::NUMBER:
+        case ExprType::STRING:
+            return true;
+        case ExprType::VARIABLE:
+            return !expr.checked;
+        case ExprType::RANDOM:
+            return false;
+        case ExprType::BINARY:
+            if (!isPure(*expr.left) || !isPure(*expr.right)) return false;
+            if (expr.op == '+') return true;
+            if (!isNumeric(*expr.left) || !isNumeric(*expr.right)) return false;
+            return expr.op != '/' || (expr.right->type == ExprType::NUMBER && expr.right->number != 0);
+    }
+    return false;
+}
+
+// A variable always holds a number when every assignment to it stores one:
+// compound assignments and ++/-- never change a variable's type, and an
+// unassigned read yields 0. Starts from "every slot is numeric" and clears
+// slots until no assignment contradicts the rest.
+void Optimizer::findNumericSlots(const Program& program) {
+    std::vector<const Stmt*> assignments;
+    collectAssignments(program.body, assignments);
+
+    numericSlots.assign(program.slotNames.size(), true);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const Stmt* stmt : assignments) {
+            if (numericSlots[stmt->slot] && !isNumeric(*stmt->value)) {
+                numericSlots[stmt->slot] = false;
+                changed = true;
+            }
+        }
+    }
+}
+
+void Optimizer::collectAssignments(const Block& block, std::vector<const Stmt*>& assignments) {
+    for (const auto& stmt : block) {
+        switch (stmt->type) {
+            case StmtType::ASSIGN:
+                assignments.push_back(stmt.get());
+                break;
+            case StmtType::IF:
+                for (const Branch& branch : stmt->branches) {
+                    collectAssignments(branch.body, assignments);
+                }
+                collectAssignments(stmt->elseBody, assignments);
+                break;
+            case StmtType::FOR:
+                collectAssignments(stmt->body, assignments);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// '-', '*' and '/' always produce a number (0 after reporting a type
+// error); '+' does only when neither side is a string.
+bool Optimizer::isNumeric(const Expr& expr) const {
+    switch (expr.type) {
+        case ExprType::NUMBER:
+        case ExprType::RANDOM:
+            return true;
+        case ExprType::STRING:
+            return false;
+        case ExprType::VARIABLE:
+            return numericSlots[expr.slot];
+        case ExprType::BINARY:
+            return expr.op != '+' || (isNumeric(*expr.left) && isNumeric(*expr.right));
+    }
+    return false;
+}
@@ -0,0 +1,71 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include "ast.hpp"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace GUMLANG {
+
+// Rewrites a resolved Program in place before either engine runs it. A
+// rewrite never changes what the program prints, error messages included,
+// so anything that could report an error at run time is left alone.
+//
+// Level 1 folds constant sub-expressions (numbers and string literals
+// joined with '+'), drops '* 1', '/ 1', '+ 0' and '- 0' on operands that
+// are always numbers, and removes if branches whose condition is constant.
+// Level 2 also replaces counted loops that only add constants to numbers
+// with a closed-form update, computes expressions that a loop never
+// changes once before it, and computes an expression repeated within one
+// iteration once. Both store the value in a temporary slot named '$tN'.
+// At either level, an assignment like 's = s + x' is marked so that the
+// engines move the old value of 's' out instead of copying it (see
+// Expr::lastUse).
+class Optimizer {
+public:
+    static constexpr int maxLevel = 2;
+
+    // When 'log' is set, every rewrite is described on it.
+    explicit Optimizer(int level, std::ostream* log = nullptr);
+    void optimize(Program& program);
+
+private:
+    enum class Truth {
+        UNKNOWN,
+        ALWAYS_TRUE,
+        ALWAYS_FALSE
+    };
+
+    void optimizeBlock(Block& block);
+    void optimizeStatement(std::unique_ptr<Stmt> stmt, Block& out);
+    void optimizeIf(std::unique_ptr<Stmt> stmt, Block& out);
+    void reduceLoop(Stmt& loop);
+    void optimizeValue(std::unique_ptr<Expr>& value, int line);
+    Truth foldCondition(std::unique_ptr<Condition>& condition);
+    void foldExpression(std::unique_ptr<Expr>& expr);
+    bool applyIdentity(std::unique_ptr<Expr>& expr);
+
+    void moveInvariants(Block& block, bool inLoop);
+    void hoistInvariants(Stmt& loop, Block& out);
+    void hoistFromBlock(Block& block, const std::vector<bool>& written, Block& hoisted, const Stmt& loop);
+    void hoistFromExpression(std::unique_ptr<Expr>& site, const std::vector<bool>& written, Block& hoisted,
+                             const Stmt& loop);
+    void eliminateCommonSubexpressions(Block& block);
+    std::unique_ptr<Stmt> makeTemporary(std::unique_ptr<Expr>& site);
+    bool isPure(const Expr& expr) const;
+
+    void findNumericSlots(const Program& program);
+    void collectAssignments(const Block& block, std::vector<const Stmt*>& assignments);
+    bool isNumeric(const Expr& expr) const;
+
+    int level;
+    std::ostream* log;
+    std::vector<bool> numericSlots; // slot only ever holds a number
+    std::vector<std::string>* slotNames = nullptr;
+};
+
+} // namespace GUMLANG
+
+#endif // OPTIMIZER_HPP
@@ -0,0 +1,30 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace GUMLANG {
+
+enum class Engine {
+    VM,
+    TREE
+};
+
+// Settings chosen on the command line.
+struct Options {
+    Engine engine = Engine::VM;
+    int optLevel = 2;               // see Optimizer
+    bool dumpOptimizations = false; // describe each rewrite on stderr
+    bool vmStats = false;           // per-opcode counts on stderr (VM only)
+    bool lineBuffered = false;      // write output after every line
+    std::optional<uint64_t> seed;   // for 'random'; a fresh seed when unset
+    bool useCache = true;           // keep compiled programs in .gumc files (VM only)
+    std::string cacheDir;           // empty: BytecodeCache::defaultDirectory()
+    std::string emitCpp;            // write the program as C++ here instead of running it
+};
+
+} // namespace GUMLANG
+
+#endif // OPTIONS_HPP
@@ -0,0 +1,136 @@
+#include "output.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+
+#if !defined(_WIN32)
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+using namespace GUMLANG;
+
+#if !defined(_WIN32)
+static bool isTerminal(int fd) {
+    return ::isatty(fd);
+}
+static const int standardOutputFd = STDOUT_FILENO;
+#else
+static bool isTerminal(int fd) {
+    return ::_isatty(fd);
+}
+static const int standardOutputFd = 1;
+#endif
+
+FileSink::FileSink(int fd, Mode mode, size_t capacity) : fd(fd), mode(mode), capacity(capacity) {
+    buffer.reserve(capacity);
+}
+
+FileSink::~FileSink() {
+    flush();
+}
+
+void FileSink::write(std::string_view text) {
+    if (buffer.size() + text.size() > capacity) {
+        writeOut(text);
+    } else {
+        buffer.append(text);
+    }
+    if (mode == Mode::LINE && !buffer.empty() && std::memchr(text.data(), '\n', text.size())) {
+        writeOut({});
+    }
+}
+
+void FileSink::flush() {
+    if (!buffer.empty()) writeOut({});
+}
+
+// Writes the buffer followed by 'extra' with as few system calls as the
+// descriptor allows, then empties the buffer. Errors such as a closed pipe
+// drop the rest, as a failed std::cout would.
+#if !defined(_WIN32)
+void FileSink::writeOut(std::string_view extra) {
+    iovec pieces[2] = {
+        {const_cast<char*>(buffer.data()), buffer.size()},
+        {const_cast<char*>(extra.data()), extra.size()},
+    };
+    iovec* next = pieces;
+    int count = 2;
+    while (count > 0) {
+        if (next->iov_len == 0) {
+            ++next;
+            --count;
+            continue;
+        }
+        ssize_t written = ::writev(fd, next, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        while (count > 0 && static_cast<size_t>(written) >= next->iov_len) {
+            written -= next->iov_len;
+            ++next;
+            --count;
+        }
+        if (count > 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + written;
+            next->iov_len -= written;
+        }
+    }
+    buffer.clear();
+}
+#else
+// Without writev the two pieces go out one after the other.
+void FileSink::writeOut(std::string_view extra) {
+    std::string_view pieces[2] = {buffer, extra};
+    for (std::string_view piece : pieces) {
+        while (!piece.empty()) {
+            unsigned size = static_cast<unsigned>(piece.size() < 1u << 30 ? piece.size() : 1u << 30);
+            int written = ::_write(fd, piece.data(), size);
+            if (written <= 0) {
+                buffer.clear();
+                return;
+            }
+            piece.remove_prefix(static_cast<size_t>(written));
+        }
+    }
+    buffer.clear();
+}
+#endif
+
+namespace {
+
+// Stream whose only job is to flush standard output; std::cerr is tied to
+// it, so it is flushed before every error message.
+class FlushBuffer : public std::streambuf {
+public:
+    explicit FlushBuffer(FileSink& sink) : sink(sink) {}
+
+protected:
+    int sync() override {
+        sink.flush();
+        return 0;
+    }
+
+private:
+    FileSink& sink;
+};
+
+struct StandardOutput {
+    FileSink sink{standardOutputFd, isTerminal(standardOutputFd) ? FileSink::Mode::LINE : FileSink::Mode::BUFFERED};
+    FlushBuffer flusher{sink};
+    std::ostream stream{&flusher};
+
+    StandardOutput() { std::cerr.tie(&stream); }
+    ~StandardOutput() { std::cerr.tie(nullptr); }
+};
+
+} // namespace
+
+FileSink& GUMLANG::standardOutput() {
+    static StandardOutput output;
+    return output.sink;
+}
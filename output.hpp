@@ -0,0 +1,69 @@
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace GUMLANG {
+
+// Where a program's printed output goes. Both engines write through a
+// sink, so output can be sent to a file descriptor or, when the
+// interpreter is embedded, kept in memory.
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+    virtual void write(std::string_view text) = 0;
+    virtual void flush() {}
+};
+
+// Writes to a file descriptor through a userspace buffer, so a print is a
+// copy rather than a system call. The buffer goes out when the next piece
+// would overflow it, on flush() and when the sink is destroyed; the piece
+// that would overflow it is handed to the same writev() call instead of
+// being copied (on Windows, which has no writev(), the two go out one
+// after the other). In LINE mode the buffer also goes out after every
+// complete line, for interactive use.
+class FileSink : public OutputSink {
+public:
+    enum class Mode {
+        BUFFERED,
+        LINE
+    };
+
+    explicit FileSink(int fd, Mode mode = Mode::BUFFERED, size_t capacity = 64 * 1024);
+    ~FileSink() override;
+
+    void write(std::string_view text) override;
+    void flush() override;
+    void setMode(Mode mode) { this->mode = mode; }
+
+private:
+    void writeOut(std::string_view extra);
+
+    int fd;
+    Mode mode;
+    size_t capacity;
+    std::string buffer;
+};
+
+// Keeps everything written, for embedding and benchmarks.
+class MemorySink : public OutputSink {
+public:
+    void write(std::string_view text) override { buffer.append(text); }
+    const std::string& contents() const { return buffer; }
+    void clear() { buffer.clear(); }
+
+private:
+    std::string buffer;
+};
+
+// Standard output, created on first use: line buffered when it is a
+// terminal, fully buffered otherwise. It is flushed at exit and before
+// anything is written to std::cerr, so errors stay in order with output
+// when both go to the same place.
+FileSink& standardOutput();
+
+} // namespace GUMLANG
+
+#endif // OUTPUT_HPP
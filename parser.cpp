@@ -1,829 +1,527 @@
 #include "parser.hpp"
+#include "cache.hpp"
+#include "compiler.hpp"
+#include "evaluator.hpp"
+#include "optimizer.hpp"
+#include "resolver.hpp"
+#include "transpiler.hpp"
+#include "vm.hpp"
+#include <charconv>
+#include <fstream>
 using namespace GUMLANG;
 
-Parser::Parser(const std::string& filename)
-    : lexer(""), currentToken({TokenType::TOKEN_UNKNOWN, "", 0, 0})
-{
-    file.open(filename);
-
-    if (!file.is_open()) {
-        std::cerr << "Cannot open source file. Try opening from a different directory." << std::endl;
-    } else {
-        if (!hasGumExtension(filename)) {
-            std::cerr << filename + " is not a GUM sourcefile." << std::endl;
-            isGumSourceFile = false;
-        }
-        std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-        lexer = Lexer(source);
-        advanceToken();
-    }
+static std::string describeToken(const Token& token) {
+    if (token.type == TokenType::TOKEN_EOL) return "end of line";
+    if (token.type == TokenType::TOKEN_EOF) return "end of file";
+    return std::string(token.value);
 }
 
-void Parser::InterpretFile() {
-    if (!file.is_open()) return;
-    if (!isGumSourceFile) return;
-
-    while (currentToken.type != TokenType::TOKEN_EOF) {
-        parseLine();
-    }
+// Leading integer part of a number token ('2.5' gives 2), like std::stoi.
+static bool parseInteger(std::string_view text, int& value) {
+    return std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc();
 }
 
-void Parser::parseBlock() {
-    while (currentToken.type != TokenType::TOKEN_RBRACE) {
-        if (currentToken.type == TokenType::TOKEN_EOF) {
-            std::cerr << "Syntax error: unexpected end of file in block." << std::endl;
-            exit(1);
-        }
-        parseLine();
-    }
-    advanceToken(); // consume '}'
+static double parseNumber(std::string_view text) {
+    double value = 0.0;
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
 }
 
-void Parser::advanceToken() {
-    currentToken = lexer.getNextToken();
-}
+namespace {
 
-void Parser::expectToken(TokenType type) {
-    if (currentToken.type != type) {
-        std::cerr << "Syntax error: expected token type " << static_cast<int>(type)
-                  << ", but got " << static_cast<int>(currentToken.type) << std::endl;
-        exit(1);
-    }
-    advanceToken();
-}
+// Binary operators by binding strength; all are left-associative. A new
+// operator only needs an entry here and a case in runtime.cpp.
+struct BinaryOperator {
+    std::string_view spelling;
+    char op;
+    int precedence;
+};
 
-void Parser::parseIfStatement() {
-    advanceToken(); // consume 'if'
-    
-    std::string condition;
-    while (currentToken.type != TokenType::TOKEN_THEN && currentToken.type != TokenType::TOKEN_LBRACE && currentToken.type != TokenType::TOKEN_EOL) {
-        condition += currentToken.value + " ";
-        advanceToken();
-    }
+constexpr BinaryOperator binaryOperators[] = {
+    {"+", '+', 1},
+    {"-", '-', 1},
+    {"*", '*', 2},
+    {"/", '/', 2},
+};
 
-    if (currentToken.type == TokenType::TOKEN_THEN)
-        advanceToken(); // consume 'then'
+} // namespace
 
-    bool conditionResult = evaluateCondition(condition);
+static const BinaryOperator* findBinaryOperator(const Token& token) {
+    if (token.type != TokenType::TOKEN_OPERATOR) return nullptr;
+    for (const BinaryOperator& entry : binaryOperators) {
+        if (entry.spelling == token.value) return &entry;
+    }
+    return nullptr;
+}
 
-    if (currentToken.type == TokenType::TOKEN_EOL)
-        advanceToken();
+static std::unique_ptr<Condition> joinConditions(ConditionType type, std::unique_ptr<Condition> first,
+                                                 std::unique_ptr<Condition> second) {
+    auto condition = std::make_unique<Condition>();
+    condition->type = type;
+    condition->first = std::move(first);
+    condition->second = std::move(second);
+    return condition;
+}
 
-    if (currentToken.type == TokenType::TOKEN_LBRACE) {
-        advanceToken(); // consume '{'
-        if (conditionResult) {
-            parseBlock();
-            skipRemainingBlocks(); // Skip any else if or else blocks
-        } else {
-            skipBlock(); // skip if block
-            handleElseIfOrElse(); // Process else if and else blocks
-        }
+Parser::Parser(const std::string& filename)
+    : filename(filename), currentToken({TokenType::TOKEN_UNKNOWN, "", 0, 0})
+{
+    if (!source.open(filename)) {
+        std::cerr << "Cannot open source file. Try opening from a different directory." << std::endl;
     } else {
-        // Handle single-line if statement
-        if (conditionResult) {
-            parseSingleLineStatement();
-            skipRemainingBlocks(); // Skip any else if or else blocks
-        } else {
-            // Skip to the end of the single-line statement
-            while (currentToken.type != TokenType::TOKEN_EOF && currentToken.type != TokenType::TOKEN_EOL) {
-                advanceToken();
-            }
-            if (currentToken.type == TokenType::TOKEN_EOL) {
-                advanceToken(); // consume EOL if present
-            }
-            handleElseIfOrElse(); // Process else if and else blocks
+        if (!hasGumExtension(filename)) {
+            std::cerr << filename + " is not a GUM sourcefile." << std::endl;
+            isGumSourceFile = false;
         }
     }
-    handleElseIfOrElse(); // Process else if and else blocks
 }
 
-void Parser::handleElseIfOrElse() {
-    bool conditionMet = false;
+// With an up-to-date .gumc file the VM runs the mapped chunk and the file
+// is never lexed or parsed. --dump-opt always goes through the front end,
+// since its output comes from the optimizer, and so does --emit-cpp, which
+// writes the optimized program out instead of running it.
+bool Parser::InterpretFile(const Options& options) {
+    if (!source.isOpen() || !isGumSourceFile) return false;
 
-    while (currentToken.type == TokenType::TOKEN_ELSEIF || currentToken.type == TokenType::TOKEN_ELSE) {
-        if (currentToken.type == TokenType::TOKEN_ELSEIF) {
-            advanceToken(); // consume 'else if'
+    bool useCache = options.useCache && options.engine == Engine::VM && !options.dumpOptimizations &&
+                    options.emitCpp.empty();
+    BytecodeCache cache(options.cacheDir.empty() ? BytecodeCache::defaultDirectory() : options.cacheDir);
+    MappedChunk cached;
+    if (useCache) cached = cache.load(filename, source.text(), options.optLevel);
 
-            std::string condition;
-            while (currentToken.type != TokenType::TOKEN_THEN && currentToken.type != TokenType::TOKEN_LBRACE && currentToken.type != TokenType::TOKEN_EOL) {
-                condition += currentToken.value + " ";
-                advanceToken();
-            }
+    Program program;
+    if (!cached) {
+        if (!parseProgram(program)) return false;
+        Optimizer(options.optLevel, options.dumpOptimizations ? &std::cerr : nullptr).optimize(program);
+    }
+    if (!options.emitCpp.empty()) {
+        std::ofstream file(options.emitCpp);
+        file << Transpiler().transpile(program, filename);
+        if (!file.flush()) {
+            std::cerr << "Cannot write " << options.emitCpp << std::endl;
+            return false;
+        }
+        return true;
+    }
+    if (options.lineBuffered) standardOutput().setMode(FileSink::Mode::LINE);
+    uint64_t seed = options.seed ? *options.seed : RandomEngine::randomSeed();
 
-            if (currentToken.type == TokenType::TOKEN_THEN)
-                advanceToken(); // consume 'then'
+    if (options.engine == Engine::TREE) {
+        Evaluator evaluator(standardOutput(), seed);
+        evaluator.run(program);
+        return true;
+    }
 
-            bool conditionResult = evaluateCondition(condition);
+    Chunk chunk;
+    if (!cached) {
+        chunk = Compiler().compile(program);
+        if (useCache) cache.store(filename, source.text(), options.optLevel, chunk);
+    }
+    VM vm(standardOutput(), seed);
+    vm.countInstructions(options.vmStats);
+    vm.run(cached ? cached.view() : chunk.view());
+    if (options.vmStats) vm.printInstructionCounts(std::cerr);
+    return true;
+}
 
-            if (currentToken.type == TokenType::TOKEN_EOL)
-                advanceToken();
+bool Parser::parseProgram(Program& program) {
+    if (!source.isOpen()) return false;
+    if (!isGumSourceFile) return false;
 
-            if (currentToken.type == TokenType::TOKEN_LBRACE) {
-                advanceToken(); // consume '{'
-                if (conditionResult && !conditionMet) {
-                    parseBlock();
-                    conditionMet = true;
-                } else {
-                    skipBlock(); // skip this else if block
-                }
-            }
-        } else if (currentToken.type == TokenType::TOKEN_ELSE) {
-            advanceToken(); // consume 'else'
-            if (currentToken.type == TokenType::TOKEN_LBRACE) {
-                advanceToken(); // consume '{'
-                if (!conditionMet) {
-                    parseBlock(); // parse else block
-                } else {
-                    skipBlock(); // skip else block
-                }
-            } else {
-                std::cerr << "Syntax error: else must be followed by a block enclosed in braces." << std::endl;
-                exit(1);
-            }
-        }
+    tokenize();
+    currentToken = tokens.front();
+    while (currentToken.type != TokenType::TOKEN_EOF) {
+        parseLine(program.body);
     }
+    return Resolver().resolve(program);
 }
 
-void Parser::skipRemainingBlocks() {
-    while (currentToken.type == TokenType::TOKEN_ELSEIF || currentToken.type == TokenType::TOKEN_ELSE) {
-        advanceToken(); // consume 'else if' or 'else'
-        if (currentToken.type == TokenType::TOKEN_LBRACE) {
-            skipBlock(); // skip the block
-        } else {
-            // Skip single-line else if or else statements
-            while (currentToken.type != TokenType::TOKEN_EOF && currentToken.type != TokenType::TOKEN_EOL) {
-                advanceToken();
-            }
-            if (currentToken.type == TokenType::TOKEN_EOL) {
-                advanceToken(); // consume EOL if present
-            }
-        }
-    }
+// Lexes the whole file up front; the parser then walks the array by index.
+// The final token is always TOKEN_EOF, and advancing past it stays there.
+void Parser::tokenize() {
+    Lexer lexer(source.text());
+    tokens.clear();
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::TOKEN_EOF);
+    position = 0;
 }
 
-void Parser::parseForLoop() {
-    advanceToken(); // consume 'for'
-    if (currentToken.type != TokenType::TOKEN_NUMBER) {
-    std::cerr << "Syntax error: expected a number of cycles for 'for' loop, but got: " << currentToken.value << std::endl;
-        exit(1);
-    }
-    int cycles = 0;
-    try {
-        cycles = std::stoi(currentToken.value);
-    } catch (const std::invalid_argument& e) {
-        std::cerr << "Syntax error: invalid number of cycles for 'for' loop: " << currentToken.value << std::endl;
-        exit(1);
+void Parser::advanceToken() {
+    if (position + 1 < tokens.size()) {
+        position++;
     }
+    currentToken = tokens[position];
+}
 
-    advanceToken(); // consume the cycle amount
-
-    if (currentToken.type == TokenType::TOKEN_LBRACE) {
-        advanceToken(); // consume '{'
-        std::vector<std::string> loopBody;
-        std::string loopLine;
-
-        while (currentToken.type != TokenType::TOKEN_RBRACE) {
-            if (currentToken.type == TokenType::TOKEN_EOF) {
-                std::cerr << "Syntax error: unexpected end of file in 'for' loop." << std::endl;
-                exit(1);
-            }
-            if (currentToken.type == TokenType::TOKEN_EOL) {
-                if (!loopLine.empty()) {
-                    loopBody.push_back(loopLine);
-                    loopLine.clear();
-                }
-            } else {
-                loopLine += currentToken.value + " ";
-            }
-            advanceToken();
-        }
-        if (!loopLine.empty()) {
-            loopBody.push_back(loopLine); // Add the last line if not empty
-        }
-        advanceToken(); // consume '}'
-
-        for (int i = 0; i < cycles; ++i) {
-            for (const auto& line : loopBody) {
-                std::istringstream iss(line);
-                lexer = Lexer(line);
-                advanceToken();
-                parseLine();
-            }
-        }
+void Parser::syntaxError(const std::string& message) {
+    std::cerr << "Syntax error: " << message << " at line " << currentToken.line
+              << ", column " << currentToken.column << std::endl;
+    exit(1);
+}
 
-        if (currentToken.type == TokenType::TOKEN_EOL) {
-            advanceToken(); // consume EOL if present
-        }
-    } else {
-        // Handle single-line for loop
-        std::string singleLineStatement;
-        while (currentToken.type != TokenType::TOKEN_EOL && currentToken.type != TokenType::TOKEN_EOF) {
-            singleLineStatement += currentToken.value + " ";
-            advanceToken();
-        }
-        for (int i = 0; i < cycles; ++i) {
-            lexer = Lexer(singleLineStatement);
-            advanceToken();
-            parseLine();
-        }
-        if (currentToken.type == TokenType::TOKEN_EOL) {
-            advanceToken(); // consume EOL if present
-        }
+void Parser::parseLine(Block& block) {
+    if (currentToken.type == TokenType::TOKEN_EOL) {
+        advanceToken(); // blank line
+        return;
     }
-}
 
-void Parser::parsePrintStatement() {
-    advanceToken(); // consume 'print'
+    block.push_back(parseStatement());
 
-    if (currentToken.type == TokenType::TOKEN_STRING) {
-        // Handle printing a string literal
-        std::cout << currentToken.value << std::endl;
-        advanceToken(); // consume the string token
-    } else {
-        // Handle expression printing
-        std::string content;
-        while (currentToken.type != TokenType::TOKEN_EOF && currentToken.type != TokenType::TOKEN_EOL) {
-            content += currentToken.value + " ";
-            advanceToken();
-        }
-        handleExpression(content);
+    if (!atStatementEnd()) {
+        syntaxError("unexpected token: " + describeToken(currentToken));
     }
-
     if (currentToken.type == TokenType::TOKEN_EOL) {
-        advanceToken(); // consume EOL if present
+        advanceToken(); // consume EOL
     }
 }
 
-void Parser::parseLine() {
-    if (currentToken.type == TokenType::TOKEN_IF) {
-        parseIfStatement();
-    } else if (currentToken.type == TokenType::TOKEN_PRINT) {
-        parsePrintStatement();
-    } else if (currentToken.type == TokenType::TOKEN_FOR) {
-        parseForLoop();
-    } else if (currentToken.type == TokenType::TOKEN_RANDOM) {
-        parseRandom();
-    } else if (currentToken.type == TokenType::TOKEN_IDENTIFIER) {
-        std::string varName = currentToken.value;
-        advanceToken();
-        if (currentToken.type == TokenType::TOKEN_ASSIGN) {
-            advanceToken(); // consume '='
-            if (currentToken.type == TokenType::TOKEN_IDENTIFIER)
-            {
-                std::string secondVarName = currentToken.value;
-                advanceToken();
-                if (currentToken.type == TokenType::TOKEN_EOL) {
-                    // Syntax: var1 var2 EOL
-                    // Assign var1's value to var2
-                    if (variables.find(varName) == variables.end()) {
-                        std::cerr << "Undefined variable: " << varName << std::endl;
-                        return;
-                    }
-                    if (variables.find(secondVarName) == variables.end()) {
-                        std::cerr << "Undefined variable: " << secondVarName << std::endl;
-                        return;
-                    }
-                    variables[varName] = variables[secondVarName];
-                    advanceToken(); // consume EOL
-                } else {
-                    std::cerr << "Syntax error: expected EOL after variable assignment." << std::endl;
-                }
-            }
-            else
-            {
-                parseAssignment(varName);
-            }
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_PLUSEQUAL) {
-            advanceToken(); // consume '+='
-            parseAdditionAssignment(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_MINUSEQUAL) {
-            advanceToken(); // consume '-='
-            parseSubtractionAssignment(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_STAREQUAL) {
-            advanceToken(); // consume '*='
-            parseMultiplicationAssignment(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_SLASHEQUAL) {
-            advanceToken(); // consume '/='
-            parseDivisionAssignment(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_INCREMENT) {
-            advanceToken(); // consume '++'
-            parseIncrement(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_DECREMENT) {
-            advanceToken(); // consume '--'
-            parseDecrement(varName);
-        } else if (currentToken.type == TokenType::TOKEN_IDENTIFIER) {
-            // Check for variable assignment to another variable
-            std::string secondVarName = currentToken.value;
-            advanceToken();
-            if (currentToken.type == TokenType::TOKEN_EOL) {
-                // Syntax: var1 var2 EOL
-                // Assign var1's value to var2
-                if (variables.find(varName) == variables.end()) {
-                    std::cerr << "Undefined variable: " << varName << std::endl;
-                    return;
-                }
-                if (variables.find(secondVarName) == variables.end()) {
-                    std::cerr << "Undefined variable: " << secondVarName << std::endl;
-                    return;
-                }
-                variables[varName] = variables[secondVarName];
-                advanceToken(); // consume EOL
-            } else {
-                std::cerr << "Syntax error: expected EOL after variable assignment." << std::endl;
-            }
-        } else if (currentToken.type == TokenType::TOKEN_NUMBER || currentToken.type == TokenType::TOKEN_STRING) {
-            parseVariableDeclaration(varName);
-        } else if (currentToken.type == TokenType::TOKEN_EOL) {
-            parseVariableDeclaration(varName);
-        } else {
-            std::cerr << "Syntax error: invalid line format: " << varName << std::endl;
-        }
-    } else if (currentToken.type == TokenType::TOKEN_EOL) {
-        advanceToken(); // consume EOL and continue
-    } else {
-        std::cerr << "Syntax error: unexpected token: " << currentToken.value << std::endl;
-        advanceToken(); // consume the unexpected token and continue
-    }
+bool Parser::atStatementEnd() const {
+    return currentToken.type == TokenType::TOKEN_EOL || currentToken.type == TokenType::TOKEN_EOF ||
+           currentToken.type == TokenType::TOKEN_RBRACE;
 }
 
-void Parser::parseSingleLineStatement() {
-    if (currentToken.type == TokenType::TOKEN_PRINT) {
-        parsePrintStatement();
-    } else if (currentToken.type == TokenType::TOKEN_IDENTIFIER) {
-        std::string varName = currentToken.value;
-        advanceToken();
-        if (currentToken.type == TokenType::TOKEN_ASSIGN) {
-            advanceToken(); // consume '='
-            parseAssignment(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_PLUSEQUAL) {
-            advanceToken(); // consume '+='
-            parseAdditionAssignment(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_MINUSEQUAL) {
-            advanceToken(); // consume '-='
-            parseSubtractionAssignment(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_STAREQUAL) {
-            advanceToken(); // consume '*='
-            parseMultiplicationAssignment(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_SLASHEQUAL) {
-            advanceToken(); // consume '/='
-            parseDivisionAssignment(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_INCREMENT) {
-            advanceToken(); // consume '++'
-            parseIncrement(varName);
-        } else if (currentToken.type == TokenType::TOKEN_OPERATOR_DECREMENT) {
-            advanceToken(); // consume '--'
-            parseDecrement(varName);
-        } else if (currentToken.type == TokenType::TOKEN_NUMBER || currentToken.type == TokenType::TOKEN_STRING) {
-            parseVariableDeclaration(varName);
-        } else {
-            std::cerr << "Syntax error: invalid line format: " << varName << std::endl;
-        }
-    } else {
-        std::cerr << "Syntax error: unexpected token: " << currentToken.value << std::endl;
-        advanceToken(); // consume the unexpected token and continue
+std::unique_ptr<Stmt> Parser::parseStatement() {
+    switch (currentToken.type) {
+        case TokenType::TOKEN_IF:
+            return parseIfStatement();
+        case TokenType::TOKEN_PRINT:
+            return parsePrintStatement();
+        case TokenType::TOKEN_FOR:
+            return parseForLoop();
+        case TokenType::TOKEN_RANDOM:
+            return parseRandom();
+        case TokenType::TOKEN_IDENTIFIER:
+            if (atFlushStatement()) return parseFlushStatement();
+            return parseVariableStatement();
+        default:
+            syntaxError("unexpected token: " + describeToken(currentToken));
     }
 }
 
-void Parser::parseVariableDeclaration(const std::string& varName) {
-    if (currentToken.type == TokenType::TOKEN_NUMBER) {
-        variables[varName] = Variable(varName, std::stod(currentToken.value));
-    } else if (currentToken.type == TokenType::TOKEN_STRING) {
-        // Remove surrounding quotes if present
-        std::string value = currentToken.value;
-        if (value.front() == '"' && value.back() == '"') {
-            value = value.substr(1, value.size() - 2);
+// 'flush' is not a keyword: on its own it is the flush statement, and
+// anywhere else it is an ordinary variable name, so scripts written
+// before the statement existed keep working.
+bool Parser::atFlushStatement() const {
+    if (currentToken.value != "flush" || position + 1 >= tokens.size()) return false;
+    TokenType next = tokens[position + 1].type;
+    return next == TokenType::TOKEN_EOL || next == TokenType::TOKEN_EOF || next == TokenType::TOKEN_RBRACE;
+}
+
+Block Parser::parseBlock() {
+    Token open = currentToken;
+    advanceToken(); // consume '{'
+
+    Block block;
+    while (currentToken.type != TokenType::TOKEN_RBRACE) {
+        if (currentToken.type == TokenType::TOKEN_EOF) {
+            syntaxError("unexpected end of file; block opened at line " + std::to_string(open.line) +
+                        ", column " + std::to_string(open.column) + " is not closed");
         }
-        variables[varName] = Variable(varName, value);
-    } else {
-        std::cerr << "Syntax error: expected a number or string for variable declaration." << std::endl;
+        parseLine(block);
     }
-    advanceToken();
+    advanceToken(); // consume '}'
+    return block;
 }
 
-void Parser::parseAssignment(const std::string& varName) {
-    std::string value;
-    while (currentToken.type != TokenType::TOKEN_EOF && currentToken.type != TokenType::TOKEN_EOL &&
-           currentToken.type != TokenType::TOKEN_LBRACE && currentToken.type != TokenType::TOKEN_RBRACE &&
-           currentToken.type != TokenType::TOKEN_IF && currentToken.type != TokenType::TOKEN_THEN &&
-           currentToken.type != TokenType::TOKEN_ELSE && currentToken.type != TokenType::TOKEN_PRINT && currentToken.type != TokenType::TOKEN_FOR) {
-        value += currentToken.value + " ";
-        advanceToken();
+// Body of an if/else branch or a for loop: either a braced block or a
+// single statement on the same line.
+Block Parser::parseBody() {
+    if (currentToken.type == TokenType::TOKEN_LBRACE) {
+        return parseBlock();
     }
-    // Remove surrounding quotes if present
-    if (value.front() == '"' && value.back() == '"') {
-        value = value.substr(1, value.size() - 2);
+    if (atStatementEnd()) {
+        syntaxError("expected a statement or block but got " + describeToken(currentToken));
     }
-    if (isNumber(value)) {
-        variables[varName] = Variable(varName, std::stod(value));
-    } else {
-        variables[varName] = Variable(varName, value);
-    }
-}
 
-void Parser::parseAdditionAssignment(const std::string& varName) {
-    if (variables.find(varName) == variables.end()) {
-        std::cerr << "Undefined variable: " << varName << std::endl;
-        return;
-    }
+    Block block;
+    block.push_back(parseStatement());
+    return block;
+}
 
-    std::string value;
-    while (currentToken.type != TokenType::TOKEN_EOF && currentToken.type != TokenType::TOKEN_EOL) {
-        value += currentToken.value + " ";
-        advanceToken();
-    }
+std::unique_ptr<Stmt> Parser::parseIfStatement() {
+    std::unique_ptr<Stmt> stmt = makeStmt(StmtType::IF, currentToken);
+    advanceToken(); // consume 'if'
 
-    Variable right = evaluateExpression(value);
+    Branch branch;
+    branch.condition = parseCondition();
 
-    if (variables[varName].type == VariableType::NUMBER && right.type == VariableType::NUMBER) {
-        variables[varName].numberValue += right.numberValue;
-    } else if (variables[varName].type == VariableType::STRING && right.type == VariableType::STRING) {
-        variables[varName].value += right.value;
-    } else {
-        std::cerr << "Type error: incompatible types for += operation." << std::endl;
+    if (currentToken.type == TokenType::TOKEN_THEN) {
+        advanceToken(); // consume 'then'
+    } else if (currentToken.type == TokenType::TOKEN_EOL) {
+        advanceToken(); // block may start on the next line
+        if (currentToken.type != TokenType::TOKEN_LBRACE) {
+            syntaxError("expected '{' after if condition but got " + describeToken(currentToken));
+        }
     }
+    branch.body = parseBody();
+    stmt->branches.push_back(std::move(branch));
+
+    parseElseIfOrElse(*stmt);
+    return stmt;
 }
 
-void Parser::parseSubtractionAssignment(const std::string& varName) {
-    if (variables.find(varName) == variables.end()) {
-        std::cerr << "Undefined variable: " << varName << std::endl;
-        return;
-    }
+void Parser::parseElseIfOrElse(Stmt& stmt) {
+    while (currentToken.type == TokenType::TOKEN_ELSEIF) {
+        advanceToken(); // consume 'else if'
 
-    std::string value;
-    while (currentToken.type != TokenType::TOKEN_EOF && currentToken.type != TokenType::TOKEN_EOL) {
-        value += currentToken.value + " ";
-        advanceToken();
+        Branch branch;
+        branch.condition = parseCondition();
+        if (currentToken.type == TokenType::TOKEN_THEN) {
+            advanceToken(); // consume 'then'
+        }
+        branch.body = parseBody();
+        stmt.branches.push_back(std::move(branch));
     }
 
-    Variable right = evaluateExpression(value);
-
-    if (variables[varName].type == VariableType::NUMBER && right.type == VariableType::NUMBER) {
-        variables[varName].numberValue -= right.numberValue;
-    } else {
-        std::cerr << "Type error: incompatible types for -= operation." << std::endl;
+    if (currentToken.type == TokenType::TOKEN_ELSE) {
+        advanceToken(); // consume 'else'
+        stmt.hasElse = true;
+        stmt.elseBody = parseBody();
     }
 }
 
-void Parser::parseMultiplicationAssignment(const std::string& varName) {
-    if (variables.find(varName) == variables.end()) {
-        std::cerr << "Undefined variable: " << varName << std::endl;
-        return;
-    }
-
-    std::string value;
-    while (currentToken.type != TokenType::TOKEN_EOF && currentToken.type != TokenType::TOKEN_EOL) {
-        value += currentToken.value + " ";
-        advanceToken();
+// condition := and ('||' and)*
+std::unique_ptr<Condition> Parser::parseCondition() {
+    std::unique_ptr<Condition> condition = parseAndCondition();
+    while (currentToken.type == TokenType::TOKEN_OR) {
+        advanceToken(); // consume '||'
+        condition = joinConditions(ConditionType::OR, std::move(condition), parseAndCondition());
     }
+    return condition;
+}
 
-    Variable right = evaluateExpression(value);
-
-    if (variables[varName].type == VariableType::NUMBER && right.type == VariableType::NUMBER) {
-        variables[varName].numberValue *= right.numberValue;
-    } else {
-        std::cerr << "Type error: incompatible types for *= operation." << std::endl;
+// and := comparison ('&&' comparison)*
+std::unique_ptr<Condition> Parser::parseAndCondition() {
+    std::unique_ptr<Condition> condition = parseComparison();
+    while (currentToken.type == TokenType::TOKEN_AND) {
+        advanceToken(); // consume '&&'
+        condition = joinConditions(ConditionType::AND, std::move(condition), parseComparison());
     }
+    return condition;
 }
 
-void Parser::parseDivisionAssignment(const std::string& varName) {
-    if (variables.find(varName) == variables.end()) {
-        std::cerr << "Undefined variable: " << varName << std::endl;
-        return;
-    }
+std::unique_ptr<Condition> Parser::parseComparison() {
+    auto condition = std::make_unique<Condition>();
+    condition->left = parseExpression();
 
-    std::string value;
-    while (currentToken.type != TokenType::TOKEN_EOF && currentToken.type != TokenType::TOKEN_EOL) {
-        value += currentToken.value + " ";
-        advanceToken();
+    if (currentToken.type != TokenType::TOKEN_OPERATOR) {
+        syntaxError("expected a comparison operator but got " + describeToken(currentToken));
     }
 
-    Variable right = evaluateExpression(value);
+    std::string_view op = currentToken.value;
+    advanceToken(); // consume the operator
 
-    if (variables[varName].type == VariableType::NUMBER && right.type == VariableType::NUMBER) {
-        if (right.numberValue != 0) {
-            variables[varName].numberValue /= right.numberValue;
-        } else {
-            std::cerr << "Division by zero error" << std::endl;
-        }
-    } else {
-        std::cerr << "Type error: incompatible types for /= operation." << std::endl;
+    // '< =' and '> =' with a space are still read as one operator.
+    if ((op == "<" || op == ">") && currentToken.type == TokenType::TOKEN_ASSIGN) {
+        advanceToken(); // consume '='
+        op = op == "<" ? "<=" : ">=";
     }
-}
 
-void Parser::parseIncrement(const std::string& varName) {
-    if (variables.find(varName) == variables.end()) {
-        std::cerr << "Undefined variable: " << varName << std::endl;
-        return;
-    }
-    if (variables[varName].type == VariableType::NUMBER) {
-        variables[varName].numberValue += 1;
+    if (op == "==") {
+        condition->op = CompareOp::EQUAL;
+    } else if (op == "!=") {
+        condition->op = CompareOp::NOT_EQUAL;
+    } else if (op == "<") {
+        condition->op = CompareOp::LESS;
+    } else if (op == ">") {
+        condition->op = CompareOp::GREATER;
+    } else if (op == "<=") {
+        condition->op = CompareOp::LESS_EQUAL;
+    } else if (op == ">=") {
+        condition->op = CompareOp::GREATER_EQUAL;
     } else {
-        std::cerr << "Type error: ++ operation only supports numeric types." << std::endl;
+        syntaxError("invalid comparison operator: " + std::string(op));
     }
-}
 
-void Parser::parseDecrement(const std::string& varName) {
-    if (variables.find(varName) == variables.end()) {
-        std::cerr << "Undefined variable: " << varName << std::endl;
-        return;
-    }
-    if (variables[varName].type == VariableType::NUMBER) {
-        variables[varName].numberValue -= 1;
-    } else {
-        std::cerr << "Type error: -- operation only supports numeric types." << std::endl;
-    }
+    condition->right = parseExpression();
+    return condition;
 }
 
-void Parser::skipBlock() {
-    int braceCount = 1; // Starting from the opening brace
+std::unique_ptr<Stmt> Parser::parseForLoop() {
+    std::unique_ptr<Stmt> stmt = makeStmt(StmtType::FOR, currentToken);
+    advanceToken(); // consume 'for'
 
-    while (braceCount > 0) {
-        advanceToken();
-        if (currentToken.type == TokenType::TOKEN_LBRACE) {
-            braceCount++;
-        } else if (currentToken.type == TokenType::TOKEN_RBRACE) {
-            braceCount--;
-        } else if (currentToken.type == TokenType::TOKEN_EOF) {
-            std::cerr << "Syntax error: unexpected end of file while skipping block." << std::endl;
-            exit(1);
-        }
+    if (currentToken.type != TokenType::TOKEN_NUMBER) {
+        syntaxError("expected a number of cycles for 'for' loop, but got: " + describeToken(currentToken));
     }
-    advanceToken(); // consume the last '}'
-}
-
-bool Parser::evaluateCondition(const std::string& condition) {
-    std::istringstream iss(condition);
-    std::string token;
-    std::vector<std::string> tokens;
-    
-    while (iss >> token) {
-        tokens.push_back(token);
+    if (!parseInteger(currentToken.value, stmt->cycles)) {
+        syntaxError("invalid number of cycles for 'for' loop: " + describeToken(currentToken));
     }
+    advanceToken(); // consume the cycle amount
 
-    // if (tokens.size() != 3 || tokens.size() != 4) {
-        // std::cerr << "Syntax error: invalid condition: " << condition << std::endl;
-        // return false;
-    // }
-
-    Variable left = evaluateExpression(tokens[0]);
-    std::string op = tokens[1];
-    
-    std::string rightStr = tokens[2];
-    
-    Variable right;
-    
-    if(rightStr != "=")
-        right = evaluateExpression(tokens[2]);
-
-    if (left.type == VariableType::NUMBER && right.type == VariableType::NUMBER) {
-        if (op == "==") return left.numberValue == right.numberValue;
-        if (op == "!=") return left.numberValue != right.numberValue;
-        
-        if (op == "<" && rightStr != "=") {
-            return left.numberValue < right.numberValue;
-        } else if (op == "<" && rightStr == "=") {
-            return left.numberValue <= evaluateExpression(tokens[3]).numberValue;
-        }
-        
-        if (op == ">" && rightStr != "=") {
-            return left.numberValue > right.numberValue;
-        } else if (op == ">" && rightStr == "=") {
-            return left.numberValue >= evaluateExpression(tokens[3]).numberValue;
+    if (currentToken.type == TokenType::TOKEN_EOL) {
+        advanceToken(); // block may start on the next line
+        if (currentToken.type != TokenType::TOKEN_LBRACE) {
+            syntaxError("expected '{' after 'for' cycle count but got " + describeToken(currentToken));
         }
-    } else if (left.type == VariableType::STRING && right.type == VariableType::STRING) {
-        if (op == "==") return left.value == right.value;
-        if (op == "!=") return left.value != right.value;
-        std::cerr << "Unsupported operation for string types: " << condition << std::endl;
-    } else {
-        std::cerr << "Type error: incompatible types in condition: " << condition << std::endl;
     }
+    stmt->body = parseBody();
+    return stmt;
+}
 
-    return false;
+std::unique_ptr<Stmt> Parser::parsePrintStatement() {
+    std::unique_ptr<Stmt> stmt = makeStmt(StmtType::PRINT, currentToken);
+    advanceToken(); // consume 'print'
+
+    stmt->value = parseExpression();
+    return stmt;
 }
 
-void Parser::handleExpression(const std::string& content)
-{
-    Variable result = evaluateExpression(content);
-
-    if (result.type == VariableType::NUMBER)
-    {
-        // Check if the number is an integer
-        if (result.numberValue == static_cast<int>(result.numberValue))
-        {
-            std::cout << static_cast<int>(result.numberValue) << std::endl;
-        }
-        else
-        {
-            std::cout << result.numberValue << std::endl;
-        }
-    }
-    else
-    {
-        std::cout << result.value << std::endl;
-    }
+// 'flush' on its own writes out everything printed so far.
+std::unique_ptr<Stmt> Parser::parseFlushStatement() {
+    std::unique_ptr<Stmt> stmt = makeStmt(StmtType::FLUSH, currentToken);
+    advanceToken(); // consume 'flush'
+    return stmt;
 }
 
-Variable Parser::evaluateExpression(const std::string& expression) {
-    std::istringstream iss(expression);
-    return parseExpression(iss);
-}
-
-Variable Parser::parseExpression(std::istringstream& iss) {
-    Variable left = parseTerm(iss);
-    while (true) {
-        std::string token;
-        iss >> token;
-        
-        if (token == "+" || token == "-") {
-            Variable right = parseTerm(iss);
-            if (left.type == VariableType::NUMBER && right.type == VariableType::NUMBER) {
-                if (token == "+") {
-                    left.numberValue += right.numberValue;
-                } else {
-                    left.numberValue -= right.numberValue;
-                }
-            } else {
-                std::string leftValue = (left.type == VariableType::STRING) ? left.value : formatNumber(left.numberValue);
-                std::string rightValue = (right.type == VariableType::STRING) ? right.value : formatNumber(right.numberValue);
-                left = Variable("", leftValue + rightValue);
-            }
-        } else {
-            iss.putback(token[0]);
-            break;
-        }
-    }
-    return left;
+// 'random a b' on its own line prints the generated number.
+std::unique_ptr<Stmt> Parser::parseRandom() {
+    std::unique_ptr<Stmt> stmt = makeStmt(StmtType::PRINT, currentToken);
+    stmt->value = parseRandomFunction();
+    return stmt;
 }
 
-Variable Parser::parseTerm(std::istringstream& iss) {
-    Variable left = parseFactor(iss);
-    while (true) {
-        std::string token;
-        iss >> token;
-        if (token == "*" || token == "/") {
-            Variable right = parseFactor(iss);
-            if (left.type == VariableType::NUMBER && right.type == VariableType::NUMBER) {
-                if (token == "*") {
-                    left.numberValue *= right.numberValue;
-                } else {
-                    if (right.numberValue != 0) {
-                        left.numberValue /= right.numberValue;
-                    } else {
-                        std::cerr << "Division by zero error" << std::endl;
-                        return Variable("", 0.0);
-                    }
-                }
-            } else {
-                std::cerr << "Unsupported operation for non-numeric types: " << left.value << " " << token << " " << right.value << std::endl;
-                return Variable("", 0.0);
+std::unique_ptr<Stmt> Parser::parseVariableStatement() {
+    Token nameToken = currentToken;
+    advanceToken(); // consume the variable name
+
+    std::unique_ptr<Stmt> stmt;
+    switch (currentToken.type) {
+        case TokenType::TOKEN_ASSIGN:
+            advanceToken(); // consume '='
+            stmt = makeStmt(StmtType::ASSIGN, nameToken);
+            stmt->value = parseExpression();
+            break;
+        case TokenType::TOKEN_OPERATOR_PLUSEQUAL:
+        case TokenType::TOKEN_OPERATOR_MINUSEQUAL:
+        case TokenType::TOKEN_OPERATOR_STAREQUAL:
+        case TokenType::TOKEN_OPERATOR_SLASHEQUAL:
+            stmt = makeStmt(StmtType::COMPOUND_ASSIGN, nameToken);
+            stmt->op = currentToken.value[0];
+            advanceToken(); // consume the operator
+            stmt->value = parseExpression();
+            break;
+        case TokenType::TOKEN_OPERATOR_INCREMENT:
+            advanceToken(); // consume '++'
+            stmt = makeStmt(StmtType::INCREMENT, nameToken);
+            break;
+        case TokenType::TOKEN_OPERATOR_DECREMENT:
+            advanceToken(); // consume '--'
+            stmt = makeStmt(StmtType::DECREMENT, nameToken);
+            break;
+        case TokenType::TOKEN_EOL:
+        case TokenType::TOKEN_EOF:
+            syntaxError("expected a number or string for variable declaration.");
+        default:
+            if (!startsExpression()) {
+                syntaxError("invalid line format: " + describeToken(nameToken));
             }
-        } else {
-            iss.putback(token[0]);
+            // Declaration ('x 0') or copy ('x y')
+            stmt = makeStmt(StmtType::ASSIGN, nameToken);
+            stmt->value = parseExpression();
             break;
-        }
     }
-    return left;
+    stmt->name = std::string(nameToken.value);
+    return stmt;
 }
 
-Variable Parser::parseFactor(std::istringstream& iss) {
-    std::string token;
-    iss >> token;
-    
-    if (isNumber(token)) {
-        return Variable(token, std::stod(token));
-    } else if (token == "random") {
-        return parseRandomFunction(iss);
-    // } else if (token == "+") {
-        // return parseStringLiteral(iss);
-    } else if (token == "(") {
-        Variable result = parseExpression(iss);
-        iss >> token;
-        if (token != ")") {
-            std::cerr << "Syntax error: expected ')' but got " << token << std::endl;
-            return Variable("", 0.0);
-        }
-        return result;
-    } else {
-        auto it = variables.find(token);
-        if (it != variables.end()) {
-            return it->second;
-        } else {
-            std::cerr << "Undefined variable: " << token << std::endl;
-            return Variable("", 0.0);
-        }
-    }
+bool Parser::startsExpression() const {
+    return currentToken.type == TokenType::TOKEN_NUMBER || currentToken.type == TokenType::TOKEN_STRING ||
+           currentToken.type == TokenType::TOKEN_IDENTIFIER || currentToken.type == TokenType::TOKEN_RANDOM ||
+           currentToken.type == TokenType::TOKEN_LPAREN;
 }
 
-std::string Parser::formatNumber(double number) {
-    std::ostringstream oss;
-    // Check if the number is an integer
-    if (number == static_cast<int>(number)) {
-        oss << static_cast<int>(number);
-    } else {
-        oss << std::fixed << std::setprecision(2) << number;
+// Precedence climbing over binaryOperators: operands bind to the operator
+// on either side with the higher precedence, and equal precedence groups to
+// the left.
+std::unique_ptr<Expr> Parser::parseExpression(int minPrecedence) {
+    std::unique_ptr<Expr> left = parseFactor();
+    const BinaryOperator* entry;
+    while ((entry = findBinaryOperator(currentToken)) && entry->precedence >= minPrecedence) {
+        std::unique_ptr<Expr> binary = makeExpr(ExprType::BINARY, currentToken);
+        binary->op = entry->op;
+        advanceToken(); // consume the operator
+        binary->left = std::move(left);
+        binary->right = parseExpression(entry->precedence + 1);
+        left = std::move(binary);
     }
-    return oss.str();
+    return left;
 }
 
-bool Parser::isNumber(const std::string& s) {
-    char* end = nullptr;
-    double val = std::strtod(s.c_str(), &end);
-    return end != s.c_str() && *end == '\0' && val != HUGE_VAL;
+std::unique_ptr<Expr> Parser::parseFactor() {
+    std::unique_ptr<Expr> expr;
+    switch (currentToken.type) {
+        case TokenType::TOKEN_NUMBER:
+            expr = makeExpr(ExprType::NUMBER, currentToken);
+            expr->number = parseNumber(currentToken.value);
+            expr->value = Variable::number(expr->number);
+            advanceToken();
+            return expr;
+        case TokenType::TOKEN_STRING:
+            expr = makeExpr(ExprType::STRING, currentToken);
+            expr->text = std::string(currentToken.value);
+            expr->value = Variable(expr->text);
+            advanceToken();
+            return expr;
+        case TokenType::TOKEN_IDENTIFIER:
+            expr = makeExpr(ExprType::VARIABLE, currentToken);
+            expr->text = std::string(currentToken.value);
+            advanceToken();
+            return expr;
+        case TokenType::TOKEN_RANDOM:
+            return parseRandomFunction();
+        case TokenType::TOKEN_LPAREN:
+            advanceToken(); // consume '('
+            expr = parseExpression();
+            if (currentToken.type != TokenType::TOKEN_RPAREN) {
+                syntaxError("expected ')' but got " + describeToken(currentToken));
+            }
+            advanceToken(); // consume ')'
+            return expr;
+        default:
+            syntaxError("expected an expression but got " + describeToken(currentToken));
+    }
 }
 
-void Parser::parseRandom() {
+std::unique_ptr<Expr> Parser::parseRandomFunction() {
+    std::unique_ptr<Expr> expr = makeExpr(ExprType::RANDOM, currentToken);
     advanceToken(); // consume 'random'
-    if (currentToken.type != TokenType::TOKEN_NUMBER) {
-        std::cerr << "Syntax error: expected a number as the first argument to 'random'" << std::endl;
-        exit(1);
-    }
-
-    int minValue = 0;
-    int maxValue = 0;
 
-    // Parse min value
-    if (currentToken.type == TokenType::TOKEN_NUMBER) {
-        minValue = std::stoi(currentToken.value);
-        advanceToken(); // consume the min value
-    } else {
-        std::cerr << "Syntax error: expected a number as the first argument to 'random'" << std::endl;
-        exit(1);
-    }
+    expr->minValue = parseRandomBound("first");
+    expr->maxValue = parseRandomBound("second");
+    return expr;
+}
 
+int Parser::parseRandomBound(const char* which) {
     if (currentToken.type != TokenType::TOKEN_NUMBER) {
-        std::cerr << "Syntax error: expected a number as the second argument to 'random'" << std::endl;
-        exit(1);
-    }
-
-    // Parse max value
-    if (currentToken.type == TokenType::TOKEN_NUMBER) {
-        maxValue = std::stoi(currentToken.value);
-        advanceToken(); // consume the max value
-    } else {
-        std::cerr << "Syntax error: expected a number as the second argument to 'random'" << std::endl;
-        exit(1);
+        syntaxError(std::string("expected a number as the ") + which + " argument to 'random'");
     }
 
-    // Generate the random number
-    int randomNumber = generateRandomNumber(minValue, maxValue);
-    std::cout << randomNumber << std::endl;
-
-    if (currentToken.type == TokenType::TOKEN_EOL) {
-        advanceToken(); // consume EOL if present
+    int value = 0;
+    if (!parseInteger(currentToken.value, value)) {
+        syntaxError(std::string("invalid ") + which + " argument to 'random': " + describeToken(currentToken));
     }
+    advanceToken(); // consume the bound
+    return value;
 }
 
-Variable Parser::parseStringLiteral(std::istringstream& iss) {
-    std::string value;
-    std::string token;
-    
-    static char quotation = '"';
-    
-    iss >> token;
-    
-    while (token != std::to_string(quotation)) {
-        value += token;
-        iss >> token;
-    }
-    
-    return Variable(value, 0.0);
+std::unique_ptr<Stmt> Parser::makeStmt(StmtType type, const Token& token) {
+    std::unique_ptr<Stmt> stmt = std::make_unique<Stmt>();
+    stmt->type = type;
+    stmt->line = token.line;
+    stmt->column = token.column;
+    return stmt;
 }
 
-Variable Parser::parseRandomFunction(std::istringstream& iss) {
-    int minValue = 0;
-    int maxValue = 0;
-    std::string token;
-
-    // Parse min value
-    iss >> token;
-    if (isNumber(token)) {
-        minValue = std::stoi(token);
-    } else {
-        std::cerr << "Syntax error: expected a number as the first argument to 'random'" << std::endl;
-        return Variable("", 0.0);
-    }
-
-    // Parse max value
-    iss >> token;
-    if (isNumber(token)) {
-        maxValue = std::stoi(token);
-    } else {
-        std::cerr << "Syntax error: expected a number as the second argument to 'random'" << std::endl;
-        return Variable("", 0.0);
-    }
-
-    // Generate the random number
-    int randomNumber = generateRandomNumber(minValue, maxValue);
-    return Variable("", static_cast<double>(randomNumber));
-}
-
-// Helper function to generate random numbers
-int Parser::generateRandomNumber(int minValue, int maxValue) {
-    std::random_device rd; // Obtain a random number from hardware
-    std::mt19937 eng(rd()); // Seed the generator
-    std::uniform_int_distribution<> distr(minValue, maxValue); // Define the range
-
-    return distr(eng);
+std::unique_ptr<Expr> Parser::makeExpr(ExprType type, const Token& token) {
+    std::unique_ptr<Expr> expr = std::make_unique<Expr>();
+    expr->type = type;
+    expr->line = token.line;
+    expr->column = token.column;
+    return expr;
 }
 
 bool Parser::hasGumExtension(const std::string& filename)
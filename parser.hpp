@@ -1,74 +1,66 @@
 #ifndef PARSER_HPP
 #define PARSER_HPP
 
+#include "ast.hpp"
 #include "lexer.hpp"
-#include "variable.hpp"
-#include <fstream>
-#include <ostream>
+#include "options.hpp"
+#include "source.hpp"
 #include <iostream>
-#include <sstream>
+#include <memory>
 #include <string>
-#include <iomanip>
-#include <unordered_map>
-#include <random>
+#include <vector>
 
 namespace GUMLANG {
 
+// Front end: turns a .gum file into a Program once. Execution happens
+// separately, either on the VM (vm.hpp) or by walking the tree
+// (evaluator.hpp).
 class Parser {
 public:
     Parser(const std::string& filename);
-    void InterpretFile();
+    bool InterpretFile(const Options& options = Options());
+    bool parseProgram(Program& program);
 
 private:
-    void parseIfStatement();
-    void handleElseIfOrElse();
-    void parseSingleLineStatement();
-    void parseForLoop();
-    void parsePrintStatement();
-    void parseAdditionAssignment(const std::string& varName);
-    void parseSubtractionAssignment(const std::string& varName);
-    void parseMultiplicationAssignment(const std::string& varName);
-    void parseDivisionAssignment(const std::string& varName);
-    void parseIncrement(const std::string& varName);
-    void parseDecrement(const std::string& varName);
-    void parseLine();
-    void parseBlock();
-    void skipBlock();
-    bool evaluateCondition(const std::string& condition);
-    Variable evaluateExpression(const std::string& expression);
-    Variable parseExpression(std::istringstream& iss);
-    Variable parseTerm(std::istringstream& iss);
-    Variable parseFactor(std::istringstream& iss);
-    void handleExpression(const std::string& content);
+    void parseLine(Block& block);
+    std::unique_ptr<Stmt> parseStatement();
+    std::unique_ptr<Stmt> parseIfStatement();
+    void parseElseIfOrElse(Stmt& stmt);
+    std::unique_ptr<Stmt> parseForLoop();
+    std::unique_ptr<Stmt> parsePrintStatement();
+    std::unique_ptr<Stmt> parseFlushStatement();
+    std::unique_ptr<Stmt> parseRandom();
+    std::unique_ptr<Stmt> parseVariableStatement();
+    Block parseBody();
+    Block parseBlock();
+    std::unique_ptr<Condition> parseCondition();
+    std::unique_ptr<Condition> parseAndCondition();
+    std::unique_ptr<Condition> parseComparison();
 
-    void parseVariableDeclaration(const std::string& varName);
-    void parseAssignment(const std::string& varName);
-    void skipRemainingBlocks();
+    std::unique_ptr<Expr> parseExpression(int minPrecedence = 1);
+    std::unique_ptr<Expr> parseFactor();
+    std::unique_ptr<Expr> parseRandomFunction();
+    int parseRandomBound(const char* which);
 
-    std::string formatNumber(double number);
-    int generateRandomNumber(int minValue, int maxValue);
-    void parseRandom();
-    Variable parseStringLiteral(std::istringstream& iss);
-    Variable parseRandomFunction(std::istringstream& iss);
-    bool isNumber(const std::string& s);
+    std::unique_ptr<Stmt> makeStmt(StmtType type, const Token& token);
+    std::unique_ptr<Expr> makeExpr(ExprType type, const Token& token);
+    bool startsExpression() const;
+    bool atStatementEnd() const;
+    bool atFlushStatement() const;
     bool hasGumExtension(const std::string& filename);
-    
-    Variable parseVariable();
-    Variable parseExpression();
-    Variable parse();
 
-    std::ifstream file;
-    Lexer lexer;
+    std::string filename;
+    SourceFile source;
+    std::vector<Token> tokens;
+    size_t position = 0;
     Token currentToken;
-    std::unordered_map<std::string, Variable> variables;
     bool isGumSourceFile = true;
 
+    void tokenize();
     void advanceToken();
-    void expectToken(TokenType type);
+    [[noreturn]] void syntaxError(const std::string& message);
 };
 
 } // namespace GUMLANG
 
 #endif // PARSER_HPP
-
-
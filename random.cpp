@@ -0,0 +1,62 @@
+#include "random.hpp"
+#include <random>
+#include <utility>
+using namespace GUMLANG;
+
+static uint64_t rotateLeft(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// splitmix64 spreads any seed, 0 included, over the four state words.
+RandomEngine::RandomEngine(uint64_t seed) {
+    for (uint64_t& word : state) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        word = z ^ (z >> 31);
+    }
+}
+
+uint64_t RandomEngine::randomSeed() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) | device();
+}
+
+void RandomEngine::refill() {
+    uint64_t s0 = state[0], s1 = state[1], s2 = state[2], s3 = state[3];
+    for (uint64_t& value : block) {
+        value = rotateLeft(s1 * 5, 7) * 9;
+        uint64_t t = s1 << 17;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = rotateLeft(s3, 45);
+    }
+    state[0] = s0;
+    state[1] = s1;
+    state[2] = s2;
+    state[3] = s3;
+    used = 0;
+}
+
+// Lemire's multiply-and-shift: the top 32 bits of a 32x32-bit product
+// are uniform over the range once the few low products that would bias
+// it are rejected, which avoids a division in almost every call.
+int64_t RandomEngine::between(int minValue, int maxValue) {
+    if (minValue > maxValue) std::swap(minValue, maxValue);
+    uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(maxValue) - minValue) + 1;
+    uint32_t bits = static_cast<uint32_t>(next() >> 32);
+    if (range > UINT32_MAX) return static_cast<int64_t>(minValue) + bits;
+
+    uint64_t product = static_cast<uint64_t>(bits) * range;
+    if (static_cast<uint32_t>(product) < range) {
+        uint32_t threshold = static_cast<uint32_t>(-static_cast<uint32_t>(range) % static_cast<uint32_t>(range));
+        while (static_cast<uint32_t>(product) < threshold) {
+            bits = static_cast<uint32_t>(next() >> 32);
+            product = static_cast<uint64_t>(bits) * range;
+        }
+    }
+    return static_cast<int64_t>(minValue) + static_cast<int64_t>(product >> 32);
+}
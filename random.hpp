@@ -0,0 +1,42 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GUMLANG {
+
+// xoshiro256** generator behind 'random'. Each interpreter owns one, seeded
+// once, so a call costs a few shifts and adds instead of a new engine and a
+// system call. Values are generated a block at a time, in a tight loop
+// that keeps the state in registers, and handed out in order; equal seeds
+// therefore give equal sequences on every engine and optimization level.
+class RandomEngine {
+public:
+    explicit RandomEngine(uint64_t seed);
+
+    // A seed from std::random_device, for runs without --seed.
+    static uint64_t randomSeed();
+
+    uint64_t next() {
+        if (used == blockSize) refill();
+        return block[used++];
+    }
+
+    // Uniform integer in [minValue, maxValue]; the bounds may come in
+    // either order.
+    int64_t between(int minValue, int maxValue);
+
+private:
+    static constexpr size_t blockSize = 64;
+
+    void refill();
+
+    uint64_t state[4];
+    uint64_t block[blockSize];
+    size_t used = blockSize;
+};
+
+} // namespace GUMLANG
+
+#endif // RANDOM_HPP
@@ -0,0 +1,149 @@
+#include "resolver.hpp"
+#include <iostream>
+using namespace GUMLANG;
+
+bool Resolver::resolve(Program& program) {
+    slots.clear();
+    slotNames = &program.slotNames;
+    slotNames->clear();
+    ok = true;
+
+    Assigned assigned;
+    resolveBlock(program.body, assigned);
+    return ok;
+}
+
+void Resolver::resolveBlock(Block& block, Assigned& assigned) {
+    for (auto& stmt : block) {
+        resolveStatement(*stmt, assigned);
+    }
+}
+
+void Resolver::resolveStatement(Stmt& stmt, Assigned& assigned) {
+    switch (stmt.type) {
+        case StmtType::ASSIGN:
+            resolveExpression(*stmt.value, assigned);
+            stmt.slot = declare(stmt.name, assigned);
+            break;
+        case StmtType::COMPOUND_ASSIGN:
+            resolveTarget(stmt, assigned);
+            resolveExpression(*stmt.value, assigned);
+            break;
+        case StmtType::INCREMENT:
+        case StmtType::DECREMENT:
+            resolveTarget(stmt, assigned);
+            break;
+        case StmtType::PRINT:
+            resolveExpression(*stmt.value, assigned);
+            break;
+        case StmtType::FLUSH:
+            break;
+        case StmtType::IF: {
+            // Only variables assigned on every path stay assigned afterwards.
+            Assigned merged;
+            bool first = true;
+            auto meet = [&](const Assigned& path) {
+                if (first) {
+                    merged = path;
+                    first = false;
+                    return;
+                }
+                for (size_t i = 0; i < merged.size(); ++i) {
+                    merged[i] = merged[i] && isAssigned(path, static_cast<int>(i));
+                }
+            };
+
+            for (Branch& branch : stmt.branches) {
+                resolveCondition(*branch.condition, assigned);
+                Assigned inBranch = assigned;
+                resolveBlock(branch.body, inBranch);
+                meet(inBranch);
+            }
+            if (stmt.hasElse) {
+                Assigned inElse = assigned;
+                resolveBlock(stmt.elseBody, inElse);
+                meet(inElse);
+            } else {
+                meet(assigned);
+            }
+            assigned = merged;
+            break;
+        }
+        case StmtType::FOR: {
+            // A loop that runs at least once assigns whatever its body does.
+            Assigned inBody = assigned;
+            resolveBlock(stmt.body, inBody);
+            if (stmt.cycles > 0) {
+                assigned = inBody;
+            }
+            break;
+        }
+        case StmtType::STEP_LOOP:
+            break; // only created by the Optimizer, after resolving
+    }
+}
+
+void Resolver::resolveCondition(Condition& condition, const Assigned& assigned) {
+    if (condition.type == ConditionType::COMPARE) {
+        resolveExpression(*condition.left, assigned);
+        resolveExpression(*condition.right, assigned);
+    } else {
+        resolveCondition(*condition.first, assigned);
+        resolveCondition(*condition.second, assigned);
+    }
+}
+
+void Resolver::resolveExpression(Expr& expr, const Assigned& assigned) {
+    switch (expr.type) {
+        case ExprType::VARIABLE: {
+            auto it = slots.find(expr.text);
+            if (it == slots.end()) {
+                undefinedVariable(expr.text, expr.line, expr.column);
+                return;
+            }
+            expr.slot = it->second;
+            expr.checked = !isAssigned(assigned, expr.slot);
+            break;
+        }
+        case ExprType::BINARY:
+            resolveExpression(*expr.left, assigned);
+            resolveExpression(*expr.right, assigned);
+            break;
+        default:
+            break;
+    }
+}
+
+void Resolver::resolveTarget(Stmt& stmt, const Assigned& assigned) {
+    auto it = slots.find(stmt.name);
+    if (it == slots.end()) {
+        undefinedVariable(stmt.name, stmt.line, stmt.column);
+        return;
+    }
+    stmt.slot = it->second;
+    stmt.checked = !isAssigned(assigned, stmt.slot);
+}
+
+int Resolver::declare(const std::string& name, Assigned& assigned) {
+    auto it = slots.find(name);
+    int slot;
+    if (it != slots.end()) {
+        slot = it->second;
+    } else {
+        slot = static_cast<int>(slotNames->size());
+        slotNames->push_back(name);
+        slots[name] = slot;
+    }
+    assigned.resize(slotNames->size(), false);
+    assigned[slot] = true;
+    return slot;
+}
+
+bool Resolver::isAssigned(const Assigned& assigned, int slot) {
+    return slot < static_cast<int>(assigned.size()) && assigned[slot];
+}
+
+void Resolver::undefinedVariable(const std::string& name, int line, int column) {
+    std::cerr << "Undefined variable: " << name << " at line " << line << ", column " << column << std::endl;
+    ok = false;
+}
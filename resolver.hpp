@@ -0,0 +1,39 @@
+#ifndef RESOLVER_HPP
+#define RESOLVER_HPP
+
+#include "ast.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace GUMLANG {
+
+// Gives every variable a dense slot number and reports names that are used
+// before any assignment to them appears in the source. Reads that may run
+// before the variable is assigned on some path (e.g. it is only assigned
+// inside an if) are marked 'checked' so the engines test them at run time;
+// all other accesses index the slot directly.
+class Resolver {
+public:
+    bool resolve(Program& program);
+
+private:
+    using Assigned = std::vector<bool>;
+
+    void resolveBlock(Block& block, Assigned& assigned);
+    void resolveStatement(Stmt& stmt, Assigned& assigned);
+    void resolveCondition(Condition& condition, const Assigned& assigned);
+    void resolveExpression(Expr& expr, const Assigned& assigned);
+    void resolveTarget(Stmt& stmt, const Assigned& assigned);
+    int declare(const std::string& name, Assigned& assigned);
+    static bool isAssigned(const Assigned& assigned, int slot);
+    void undefinedVariable(const std::string& name, int line, int column);
+
+    std::unordered_map<std::string, int> slots;
+    std::vector<std::string>* slotNames = nullptr;
+    bool ok = true;
+};
+
+} // namespace GUMLANG
+
+#endif // RESOLVER_HPP
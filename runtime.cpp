@@ -0,0 +1,216 @@
+#include "runtime.hpp"
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <iostream>
+using namespace GUMLANG;
+
+// Text of a string operand for error messages; numbers show as empty.
+static const std::string& stringText(const Variable& value) {
+    static const std::string empty;
+    return value.type == VariableType::STRING ? value.stringValue() : empty;
+}
+
+Variable GUMLANG::binaryOperation(char op, const Variable& left, const Variable& right) {
+    Variable result;
+    if (numericBinary(op, left, right, result)) return result;
+    if (left.isNumber() && right.isNumber()) {
+        std::cerr << "Division by zero error" << std::endl;
+        return Variable(0.0);
+    }
+
+    if (op == '+') {
+        char leftText[numberTextSize], rightText[numberTextSize];
+        std::string_view first = left.type == VariableType::STRING ? std::string_view(left.stringValue())
+                                                                   : formatNumber(left.toNumber(), leftText);
+        std::string_view second = right.type == VariableType::STRING ? std::string_view(right.stringValue())
+                                                                     : formatNumber(right.toNumber(), rightText);
+        std::string result;
+        result.reserve(first.size() + second.size());
+        result.append(first).append(second);
+        return Variable(std::move(result));
+    }
+
+    std::cerr << "Unsupported operation for non-numeric types: " << stringText(left) << " " << op << " " << stringText(right) << std::endl;
+    return Variable(0.0);
+}
+
+void GUMLANG::applyBinary(char op, Variable& left, const Variable& right) {
+    if (op == '+' && left.type == VariableType::STRING) {
+        char text[numberTextSize];
+        left.appendString(right.type == VariableType::STRING ? std::string_view(right.stringValue())
+                                                             : formatNumber(right.toNumber(), text));
+    } else {
+        left = binaryOperation(op, left, right);
+    }
+}
+
+void GUMLANG::compoundAssign(char op, Variable& target, const Variable& right) {
+    if (numericBinary(op, target, right, target)) return;
+    if (target.isNumber() && right.isNumber()) {
+        std::cerr << "Division by zero error" << std::endl;
+    } else if (op == '+' && target.type == VariableType::STRING && right.type == VariableType::STRING) {
+        target.appendString(right.stringValue());
+    } else {
+        std::cerr << "Type error: incompatible types for " << op << "= operation." << std::endl;
+    }
+}
+
+void GUMLANG::stepVariable(Variable& target, double step) {
+    if (target.type == VariableType::INTEGER) {
+        int64_t result = target.integerValue + static_cast<int64_t>(step);
+        if (Variable::inIntegerRange(result)) {
+            target.integerValue = result;
+        } else {
+            target = Variable(target.toNumber() + step);
+        }
+    } else if (target.type == VariableType::NUMBER) {
+        target.numberValue += step;
+    } else {
+        std::cerr << "Type error: " << (step > 0 ? "++" : "--") << " operation only supports numeric types." << std::endl;
+    }
+}
+
+bool GUMLANG::compareValues(CompareOp op, const Variable& left, const Variable& right) {
+    if (left.type == VariableType::INTEGER && right.type == VariableType::INTEGER) {
+        int64_t a = left.integerValue, b = right.integerValue;
+        switch (op) {
+            case CompareOp::EQUAL: return a == b;
+            case CompareOp::NOT_EQUAL: return a != b;
+            case CompareOp::LESS: return a < b;
+            case CompareOp::GREATER: return a > b;
+            case CompareOp::LESS_EQUAL: return a <= b;
+            case CompareOp::GREATER_EQUAL: return a >= b;
+        }
+    } else if (left.isNumber() && right.isNumber()) {
+        double a = left.toNumber(), b = right.toNumber();
+        switch (op) {
+            case CompareOp::EQUAL: return a == b;
+            case CompareOp::NOT_EQUAL: return a != b;
+            case CompareOp::LESS: return a < b;
+            case CompareOp::GREATER: return a > b;
+            case CompareOp::LESS_EQUAL: return a <= b;
+            case CompareOp::GREATER_EQUAL: return a >= b;
+        }
+    } else if (left.type == VariableType::STRING && right.type == VariableType::STRING) {
+        if (op == CompareOp::EQUAL) return left.stringValue() == right.stringValue();
+        if (op == CompareOp::NOT_EQUAL) return left.stringValue() != right.stringValue();
+        std::cerr << "Unsupported operation for string types: " << left.stringValue() << ", " << right.stringValue() << std::endl;
+    } else {
+        std::cerr << "Type error: incompatible types in condition." << std::endl;
+    }
+
+    return false;
+}
+
+// Whole numbers in int range print as integers; anything else, including
+// larger whole numbers, prints as a double.
+static bool printsAsInteger(double number) {
+    return number >= INT_MIN && number <= INT_MAX && std::trunc(number) == number;
+}
+
+// Numbers print the way std::ostream prints an int or, with its default
+// precision of 6, a double ("%g").
+void GUMLANG::printValue(const Variable& value, OutputSink& out) {
+    if (value.type == VariableType::STRING) {
+        out.write(value.stringValue());
+        out.write("\n");
+        return;
+    }
+
+    char text[32];
+    std::to_chars_result end;
+    if (value.type == VariableType::INTEGER && value.integerValue >= INT_MIN && value.integerValue <= INT_MAX) {
+        end = std::to_chars(text, text + sizeof text - 1, value.integerValue);
+    } else if (printsAsInteger(value.toNumber())) {
+        end = std::to_chars(text, text + sizeof text - 1, static_cast<int>(value.toNumber()));
+    } else {
+        end = std::to_chars(text, text + sizeof text - 1, value.toNumber(), std::chars_format::general, 6);
+    }
+    *end.ptr++ = '\n';
+    out.write(std::string_view(text, end.ptr - text));
+}
+
+std::string_view GUMLANG::formatNumber(double number, char* buffer) {
+    std::to_chars_result end;
+    if (printsAsInteger(number)) {
+        end = std::to_chars(buffer, buffer + numberTextSize, static_cast<int>(number));
+    } else {
+        end = std::to_chars(buffer, buffer + numberTextSize, number, std::chars_format::fixed, 2);
+    }
+    return std::string_view(buffer, end.ptr - buffer);
+}
+
+static double stepDelta(const LoopStep& step) {
+    switch (step.type) {
+        case StmtType::INCREMENT: return 1;
+        case StmtType::DECREMENT: return -1;
+        default: return step.op == '-' ? -step.value : step.value;
+    }
+}
+
+// Runs 'cycles' iterations of a STEP_LOOP. When every target is a number
+// and every value the loop would pass through is an integer below 2^53,
+// each addition is exact, so adding cycles * (sum of steps) once gives the
+// same result as the loop. Anything else (strings, fractions, huge values)
+// replays the updates one iteration at a time, errors included.
+void GUMLANG::runStepLoop(int cycles, const LoopStep* steps, size_t count, Variable* slots) {
+    if (cycles <= 0) return;
+
+    const double exactLimit = 9007199254740992.0; // 2^53
+    bool exact = true;
+    for (size_t i = 0; i < count && exact; ++i) {
+        bool seen = false;
+        for (size_t j = 0; j < i; ++j) {
+            seen = seen || steps[j].slot == steps[i].slot;
+        }
+        if (seen) continue;
+
+        const Variable& target = slots[steps[i].slot];
+        if (!target.isNumber() || std::trunc(target.toNumber()) != target.toNumber()) {
+            exact = false;
+            break;
+        }
+        double magnitude = 0;
+        for (size_t j = i; j < count; ++j) {
+            if (steps[j].slot != steps[i].slot) continue;
+            double delta = stepDelta(steps[j]);
+            exact = exact && std::trunc(delta) == delta;
+            magnitude += std::fabs(delta);
+        }
+        exact = exact && std::fabs(target.toNumber()) + cycles * magnitude < exactLimit;
+    }
+
+    if (exact) {
+        for (size_t i = 0; i < count; ++i) {
+            bool seen = false;
+            for (size_t j = 0; j < i; ++j) {
+                seen = seen || steps[j].slot == steps[i].slot;
+            }
+            if (seen) continue;
+
+            double total = 0;
+            for (size_t j = i; j < count; ++j) {
+                if (steps[j].slot == steps[i].slot) total += stepDelta(steps[j]);
+            }
+            Variable& target = slots[steps[i].slot];
+            if (target.type == VariableType::INTEGER) {
+                target.integerValue += static_cast<int64_t>(cycles * total);
+            } else {
+                target.numberValue += cycles * total;
+            }
+        }
+        return;
+    }
+
+    for (int cycle = 0; cycle < cycles; ++cycle) {
+        for (size_t i = 0; i < count; ++i) {
+            const LoopStep& step = steps[i];
+            switch (step.type) {
+                case StmtType::INCREMENT: stepVariable(slots[step.slot], 1); break;
+                case StmtType::DECREMENT: stepVariable(slots[step.slot], -1); break;
+                default: compoundAssign(step.op, slots[step.slot], Variable::number(step.value)); break;
+            }
+        }
+    }
+}
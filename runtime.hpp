@@ -0,0 +1,93 @@
+#ifndef RUNTIME_HPP
+#define RUNTIME_HPP
+
+#include "ast.hpp"
+#include "output.hpp"
+#include "variable.hpp"
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace GUMLANG {
+
+// Value semantics shared by every execution engine, so the tree evaluator
+// and the VM print and compute exactly the same things.
+Variable binaryOperation(char op, const Variable& left, const Variable& right);
+// Replaces 'left' with 'left op right'; a string on the left is appended
+// to rather than copied when no other Variable shares it.
+void applyBinary(char op, Variable& left, const Variable& right);
+void compoundAssign(char op, Variable& target, const Variable& right);
+void stepVariable(Variable& target, double step);
+bool compareValues(CompareOp op, const Variable& left, const Variable& right);
+void printValue(const Variable& value, OutputSink& out);
+// Writes 'number' as it reads when joined to a string into 'buffer', which
+// must hold numberTextSize chars: a whole number in int range as an
+// integer, anything else with two decimals.
+constexpr size_t numberTextSize = 320; // sign, 309 digits, point, 2 decimals
+std::string_view formatNumber(double number, char* buffer);
+void runStepLoop(int cycles, const LoopStep* steps, size_t count, Variable* slots);
+
+// Arithmetic on two INTEGER operands. Returns false when the result is not
+// a whole number below 2^53, in which case the caller computes it in
+// double as if both were NUMBERs. The sign of a zero product or quotient
+// is lost, but nothing that prints or compares a zero can tell.
+inline bool integerArithmetic(char op, int64_t left, int64_t right, int64_t& result) {
+    switch (op) {
+        case '+': result = left + right; break;
+        case '-': result = left - right; break;
+        case '*':
+        case '/': {
+            // Both operands are exact in double, so this is the double
+            // result; it is kept when it is a whole number in range.
+            if (op == '/' && right == 0) return false;
+            double value = op == '*' ? static_cast<double>(left) * static_cast<double>(right)
+                                     : static_cast<double>(left) / static_cast<double>(right);
+            if (std::fabs(value) >= static_cast<double>(Variable::integerLimit)) return false;
+            result = static_cast<int64_t>(value);
+            return static_cast<double>(result) == value;
+        }
+        default: return false;
+    }
+    return Variable::inIntegerRange(result);
+}
+
+// The numeric half of binaryOperation, shared with the engines' fast
+// paths so every arithmetic rule lives here. Stores 'left op right' in
+// 'out', which may be one of the operands, and returns true when both are
+// numbers; returns false without touching 'out' for strings and for a
+// division by zero, which binaryOperation reports.
+inline bool numericBinary(char op, const Variable& left, const Variable& right, Variable& out) {
+    if (!left.isNumber() || !right.isNumber()) return false;
+    int64_t integer;
+    bool exact = left.type == VariableType::INTEGER && right.type == VariableType::INTEGER &&
+                 integerArithmetic(op, left.integerValue, right.integerValue, integer);
+    double number = 0;
+    if (!exact) {
+        double a = left.toNumber(), b = right.toNumber();
+        switch (op) {
+            case '+': number = a + b; break;
+            case '-': number = a - b; break;
+            case '*': number = a * b; break;
+            case '/':
+                if (b == 0) return false;
+                number = a / b;
+                break;
+            default: return false;
+        }
+    }
+    if (out.type == VariableType::STRING) out = Variable(); // numbers are then written in place
+    if (exact) {
+        out.type = VariableType::INTEGER;
+        out.integerValue = integer;
+    } else {
+        out.type = VariableType::NUMBER;
+        out.numberValue = number;
+    }
+    return true;
+}
+
+} // namespace GUMLANG
+
+#endif // RUNTIME_HPP
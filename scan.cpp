@@ -0,0 +1,218 @@
+#include "scan.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define GUM_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+static bool isIdentifierByte(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static bool isBlankByte(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Scalar kernels: the reference behaviour, and the tail of the SIMD ones.
+
+static size_t scalarFindEither(const char* data, size_t start, size_t size, char a, char b) {
+    while (start < size && data[start] != a && data[start] != b) start++;
+    return start;
+}
+
+static size_t scalarSkipIdentifier(const char* data, size_t start, size_t size) {
+    while (start < size && isIdentifierByte(data[start])) start++;
+    return start;
+}
+
+static size_t scalarSkipBlanks(const char* data, size_t start, size_t size) {
+    while (start < size && isBlankByte(data[start])) start++;
+    return start;
+}
+
+static size_t scalarCountNewlines(const char* data, size_t start, size_t end) {
+    size_t count = 0;
+    for (size_t i = start; i < end; ++i) {
+        count += data[i] == '\n';
+    }
+    return count;
+}
+
+static const ScanKernels scalarKernels = {
+    "scalar", scalarFindEither, scalarSkipIdentifier, scalarSkipBlanks, scalarCountNewlines
+};
+
+#ifdef GUM_SCAN_X86
+
+// SSE2: 16 bytes per step. Byte classes are built from signed compares, so
+// bytes >= 0x80 never count as identifier or blank characters.
+
+__attribute__((target("sse2")))
+static inline __m128i sse2IdentifierMask(__m128i bytes) {
+    __m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                   _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(bytes, _mm_set1_epi8('9' + 1)));
+    __m128i underscore = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(letter, digit), underscore);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i sse2BlankMask(__m128i bytes) {
+    // '\t', '\n', '\v', '\f', '\r' are 9..13; '\n' is taken back out.
+    __m128i control = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8('\t' - 1)),
+                                    _mm_cmplt_epi8(bytes, _mm_set1_epi8('\r' + 1)));
+    control = _mm_andnot_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')), control);
+    return _mm_or_si128(control, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')));
+}
+
+__attribute__((target("sse2")))
+static size_t sse2FindEither(const char* data, size_t start, size_t size, char a, char b) {
+    __m128i va = _mm_set1_epi8(a);
+    __m128i vb = _mm_set1_epi8(b);
+    for (; start + 16 <= size; start += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + start));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, va), _mm_cmpeq_epi8(bytes, vb)));
+        if (mask != 0) return start + __builtin_ctz(mask);
+    }
+    return scalarFindEither(data, start, size, a, b);
+}
+
+__attribute__((target("sse2")))
+static size_t sse2SkipIdentifier(const char* data, size_t start, size_t size) {
+    for (; start + 16 <= size; start += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + start));
+        int mask = ~_mm_movemask_epi8(sse2IdentifierMask(bytes)) & 0xFFFF;
+        if (mask != 0) return start + __builtin_ctz(mask);
+    }
+    return scalarSkipIdentifier(data, start, size);
+}
+
+__attribute__((target("sse2")))
+static size_t sse2SkipBlanks(const char* data, size_t start, size_t size) {
+    for (; start + 16 <= size; start += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + start));
+        int mask = ~_mm_movemask_epi8(sse2BlankMask(bytes)) & 0xFFFF;
+        if (mask != 0) return start + __builtin_ctz(mask);
+    }
+    return scalarSkipBlanks(data, start, size);
+}
+
+// __builtin_popcount without the popcnt target is the portable bit count,
+// so this set needs nothing beyond SSE2.
+__attribute__((target("sse2")))
+static size_t sse2CountNewlines(const char* data, size_t start, size_t end) {
+    size_t count = 0;
+    __m128i newline = _mm_set1_epi8('\n');
+    for (; start + 16 <= end; start += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + start));
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+    }
+    return count + scalarCountNewlines(data, start, end);
+}
+
+static const ScanKernels sse2Kernels = {
+    "sse2", sse2FindEither, sse2SkipIdentifier, sse2SkipBlanks, sse2CountNewlines
+};
+
+// AVX2: the same byte classes, 32 bytes per step.
+
+__attribute__((target("avx2")))
+static inline __m256i avx2IdentifierMask(__m256i bytes) {
+    __m256i lower = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+    __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                      _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), bytes));
+    __m256i underscore = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_'));
+    return _mm256_or_si256(_mm256_or_si256(letter, digit), underscore);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i avx2BlankMask(__m256i bytes) {
+    __m256i control = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('\t' - 1)),
+                                       _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), bytes));
+    control = _mm256_andnot_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')), control);
+    return _mm256_or_si256(control, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')));
+}
+
+__attribute__((target("avx2,bmi")))
+static size_t avx2FindEither(const char* data, size_t start, size_t size, char a, char b) {
+    __m256i va = _mm256_set1_epi8(a);
+    __m256i vb = _mm256_set1_epi8(b);
+    for (; start + 32 <= size; start += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + start));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, va), _mm256_cmpeq_epi8(bytes, vb))));
+        if (mask != 0) return start + __builtin_ctz(mask);
+    }
+    return sse2FindEither(data, start, size, a, b);
+}
+
+__attribute__((target("avx2,bmi")))
+static size_t avx2SkipIdentifier(const char* data, size_t start, size_t size) {
+    for (; start + 32 <= size; start += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + start));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(avx2IdentifierMask(bytes)));
+        if (mask != 0) return start + __builtin_ctz(mask);
+    }
+    return sse2SkipIdentifier(data, start, size);
+}
+
+__attribute__((target("avx2,bmi")))
+static size_t avx2SkipBlanks(const char* data, size_t start, size_t size) {
+    for (; start + 32 <= size; start += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + start));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(avx2BlankMask(bytes)));
+        if (mask != 0) return start + __builtin_ctz(mask);
+    }
+    return sse2SkipBlanks(data, start, size);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t avx2CountNewlines(const char* data, size_t start, size_t end) {
+    size_t count = 0;
+    __m256i newline = _mm256_set1_epi8('\n');
+    for (; start + 32 <= end; start += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + start));
+        count += __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline))));
+    }
+    return count + sse2CountNewlines(data, start, end);
+}
+
+static const ScanKernels avx2Kernels = {
+    "avx2", avx2FindEither, avx2SkipIdentifier, avx2SkipBlanks, avx2CountNewlines
+};
+
+#endif // GUM_SCAN_X86
+
+const ScanKernels& scalarScanKernels() {
+    return scalarKernels;
+}
+
+const ScanKernels* const* availableScanKernels(size_t& count) {
+    static const ScanKernels* kernels[3];
+    static size_t available = [] {
+        size_t n = 0;
+        kernels[n++] = &scalarKernels;
+#ifdef GUM_SCAN_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) {
+            kernels[n++] = &sse2Kernels;
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") && __builtin_cpu_supports("popcnt")) {
+                kernels[n++] = &avx2Kernels;
+            }
+        }
+#endif
+        return n;
+    }();
+    count = available;
+    return kernels;
+}
+
+const ScanKernels& defaultScanKernels() {
+    size_t count = 0;
+    const ScanKernels* const* kernels = availableScanKernels(count);
+    return *kernels[count - 1];
+}
@@ -0,0 +1,31 @@
+#ifndef SCAN_HPP
+#define SCAN_HPP
+
+#include <cstddef>
+
+// Bulk byte-scanning kernels used by the Lexer to skip comments, string
+// bodies, identifiers and blanks without stepping one character at a time.
+// Every function takes [data + start, data + size) and returns the index of
+// the first byte that stops the scan, or size if none does.
+struct ScanKernels {
+    const char* name;
+    // First byte equal to a or b.
+    size_t (*findEither)(const char* data, size_t start, size_t size, char a, char b);
+    // First byte that is not [A-Za-z0-9_].
+    size_t (*skipIdentifier)(const char* data, size_t start, size_t size);
+    // First byte that is not ' ', '\t', '\r', '\v' or '\f'.
+    size_t (*skipBlanks)(const char* data, size_t start, size_t size);
+    // Number of '\n' bytes in [start, end).
+    size_t (*countNewlines)(const char* data, size_t start, size_t end);
+};
+
+const ScanKernels& scalarScanKernels();
+
+// The widest kernels this CPU supports, detected once at run time.
+const ScanKernels& defaultScanKernels();
+
+// Every kernel set usable on this CPU, scalar first; 'count' receives the
+// number of entries. Used to check the SIMD paths against the scalar one.
+const ScanKernels* const* availableScanKernels(size_t& count);
+
+#endif // SCAN_HPP
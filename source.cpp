@@ -0,0 +1,63 @@
+#include "source.hpp"
+#include <fstream>
+#include <iterator>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace GUMLANG;
+
+SourceFile::~SourceFile() {
+    close();
+}
+
+bool SourceFile::open(const std::string& filename) {
+    close();
+
+#if !defined(_WIN32)
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            ::close(fd);
+            data = static_cast<const char*>(mapping);
+            size = static_cast<size_t>(info.st_size);
+            mapped = true;
+            opened = true;
+            return true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    // Empty files, pipes and platforms without mmap are read into memory.
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+    opened = true;
+    return true;
+}
+
+void SourceFile::close() {
+#if !defined(_WIN32)
+    if (mapped) {
+        munmap(const_cast<char*>(data), size);
+    }
+#endif
+    data = "";
+    size = 0;
+    mapped = false;
+    opened = false;
+    buffer.clear();
+}
@@ -0,0 +1,36 @@
+#ifndef SOURCE_HPP
+#define SOURCE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace GUMLANG {
+
+// Read-only view of a source file. The file is memory-mapped where the
+// platform allows it, so the lexer can hand out tokens that point straight
+// into the file contents without copying them.
+class SourceFile {
+public:
+    SourceFile() = default;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    ~SourceFile();
+
+    bool open(const std::string& filename);
+    bool isOpen() const { return opened; }
+    std::string_view text() const { return std::string_view(data, size); }
+
+private:
+    void close();
+
+    const char* data = "";
+    size_t size = 0;
+    bool mapped = false;
+    bool opened = false;
+    std::string buffer; // used when the file cannot be mapped
+};
+
+} // namespace GUMLANG
+
+#endif // SOURCE_HPP
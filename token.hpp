@@ -1,7 +1,7 @@
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
 
-#include <string>
+#include <string_view>
 
 enum class TokenType {
     TOKEN_EOF,
@@ -31,12 +31,17 @@ enum class TokenType {
     TOKEN_LBRACKET,
     TOKEN_RBRACKET,
     TOKEN_RANDOM,
+    TOKEN_AND,
+    TOKEN_OR,
     TOKEN_UNKNOWN
 };
 
+// A token's value is a view into the source text (or a fixed spelling for
+// operators), so producing a token never allocates. Callers copy the text
+// only when it has to outlive the source, e.g. as a constant or a name.
 struct Token {
     TokenType type;
-    std::string value;
+    std::string_view value;
     int line;
     int column;
 };
@@ -0,0 +1,575 @@
+#include "transpiler.hpp"
+#include <charconv>
+#include <cmath>
+using namespace GUMLANG;
+
+static const char* compareSpelling(CompareOp op) {
+    switch (op) {
+        case CompareOp::EQUAL: return "==";
+        case CompareOp::NOT_EQUAL: return "!=";
+        case CompareOp::LESS: return "<";
+        case CompareOp::GREATER: return ">";
+        case CompareOp::LESS_EQUAL: return "<=";
+        case CompareOp::GREATER_EQUAL: return ">=";
+    }
+    return "==";
+}
+
+static const char* compareName(CompareOp op) {
+    switch (op) {
+        case CompareOp::EQUAL: return "CompareOp::EQUAL";
+        case CompareOp::NOT_EQUAL: return "CompareOp::NOT_EQUAL";
+        case CompareOp::LESS: return "CompareOp::LESS";
+        case CompareOp::GREATER: return "CompareOp::GREATER";
+        case CompareOp::LESS_EQUAL: return "CompareOp::LESS_EQUAL";
+        case CompareOp::GREATER_EQUAL: return "CompareOp::GREATER_EQUAL";
+    }
+    return "CompareOp::EQUAL";
+}
+
+// A double literal that reads back as exactly 'value'.
+static std::string numberLiteral(double value) {
+    if (std::isnan(value)) {
+        return std::signbit(value) ? "(-std::numeric_limits<double>::quiet_NaN())"
+                                   : "std::numeric_limits<double>::quiet_NaN()";
+    }
+    if (std::isinf(value)) {
+        return value < 0 ? "(-std::numeric_limits<double>::infinity())" : "std::numeric_limits<double>::infinity()";
+    }
+    char text[32];
+    std::string literal(text, std::to_chars(text, text + sizeof text, value).ptr);
+    if (literal.find_first_of(".e") == std::string::npos) literal += ".0";
+    return std::signbit(value) ? "(" + literal + ")" : literal;
+}
+
+// Octal escapes take at most three digits, so they cannot swallow a
+// following character the way hex escapes can.
+static std::string stringLiteral(const std::string& text) {
+    std::string literal = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            literal += '\\';
+            literal += static_cast<char>(c);
+        } else if (c >= 0x20 && c < 0x7f) {
+            literal += static_cast<char>(c);
+        } else {
+            char escape[5] = {'\\', static_cast<char>('0' + (c >> 6)), static_cast<char>('0' + ((c >> 3) & 7)),
+                              static_cast<char>('0' + (c & 7)), '\0'};
+            literal += escape;
+        }
+    }
+    return literal + "\"";
+}
+
+static bool isNonZeroNumber(const Expr& expr) {
+    return expr.type == ExprType::NUMBER && expr.number != 0;
+}
+
+std::string Transpiler::transpile(const Program& program, const std::string& sourceName) {
+    strings.clear();
+    code.clear();
+    depth = 1;
+    loopDepth = 0;
+    temporaries = 0;
+    findSlotTypes(program);
+
+    emitBlock(program.body);
+    std::string body = std::move(code);
+
+    std::string out;
+    out += "// " + sourceName + ", translated to C++ by gum --emit-cpp.\n";
+    out += "// Build it with the gum runtime sources as described in native.hpp;\n";
+    out += "// like gum itself, it accepts --seed=N and --line-buffered.\n";
+    out += "#include \"native.hpp\"\n";
+    out += "#include <limits>\n";
+    out += "#include <string>\n";
+    out += "#include <utility>\n\n";
+    out += "using namespace GUMLANG;\n\n";
+    out += "int main(int argc, char* argv[]) {\n";
+    out += "    native::Runtime gum(argc, argv);\n";
+
+    std::vector<const std::string*> texts(strings.size());
+    for (const auto& entry : strings) {
+        texts[entry.second] = &entry.first;
+    }
+    for (size_t i = 0; i < texts.size(); ++i) {
+        out += "    const Variable s" + std::to_string(i) + "(std::string(" + stringLiteral(*texts[i]) + ", " +
+               std::to_string(texts[i]->size()) + "));\n";
+    }
+    for (size_t slot = 0; slot < slotTypes.size(); ++slot) {
+        std::string name = program.slotNames[slot];
+        if (slotTypes[slot] == ValueType::NUMBER) {
+            out += "    double " + local(slot) + " = 0; // " + name + "\n";
+        } else {
+            out += "    Variable " + local(slot) + "; // " + name + "\n";
+        }
+        if (checkedSlots[slot]) out += "    bool " + definedFlag(slot) + " = false;\n";
+    }
+    out += "\n" + body + "    return 0;\n}\n";
+    return out;
+}
+
+// A slot holds numbers only when every assignment to it stores one, as in
+// Optimizer::findNumericSlots, and strings only when every assignment
+// stores a string. Compound assignments and ++/-- never change the type of
+// a variable, and a slot that is never assigned only yields 0.
+void Transpiler::findSlotTypes(const Program& program) {
+    std::vector<const Stmt*> assignments;
+    checkedSlots.assign(program.slotNames.size(), false);
+    collectSlotUses(program.body, assignments);
+
+    slotTypes.assign(program.slotNames.size(), ValueType::NONE);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const Stmt* stmt : assignments) {
+            ValueType current = slotTypes[stmt->slot];
+            ValueType assigned = typeOf(*stmt->value);
+            ValueType joined = current == ValueType::NONE || current == assigned ? assigned
+                               : assigned == ValueType::NONE                     ? current
+                                                                                 : ValueType::ANY;
+            if (joined != current) {
+                slotTypes[stmt->slot] = joined;
+                changed = true;
+            }
+        }
+    }
+    for (ValueType& type : slotTypes) {
+        if (type == ValueType::NONE) type = ValueType::NUMBER;
+    }
+}
+
+void Transpiler::collectSlotUses(const Block& block, std::vector<const Stmt*>& assignments) {
+    for (const auto& stmt : block) {
+        if (stmt->checked && stmt->slot >= 0) checkedSlots[stmt->slot] = true;
+        if (stmt->value) collectCheckedReads(*stmt->value);
+        switch (stmt->type) {
+            case StmtType::ASSIGN:
+                assignments.push_back(stmt.get());
+                break;
+            case StmtType::IF:
+                for (const Branch& branch : stmt->branches) {
+                    collectCheckedReads(*branch.condition);
+                    collectSlotUses(branch.body, assignments);
+                }
+                collectSlotUses(stmt->elseBody, assignments);
+                break;
+            case StmtType::FOR:
+                collectSlotUses(stmt->body, assignments);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void Transpiler::collectCheckedReads(const Expr& expr) {
+    if (expr.type == ExprType::VARIABLE && expr.checked) checkedSlots[expr.slot] = true;
+    if (expr.left) collectCheckedReads(*expr.left);
+    if (expr.right) collectCheckedReads(*expr.right);
+}
+
+void Transpiler::collectCheckedReads(const Condition& condition) {
+    if (condition.left) collectCheckedReads(*condition.left);
+    if (condition.right) collectCheckedReads(*condition.right);
+    if (condition.first) collectCheckedReads(*condition.first);
+    if (condition.second) collectCheckedReads(*condition.second);
+}
+
+// '-', '*' and '/' always produce a number (0 after reporting a type
+// error), and so does a read of an unassigned variable; '+' produces a
+// string as soon as either side is one.
+Transpiler::ValueType Transpiler::typeOf(const Expr& expr) const {
+    switch (expr.type) {
+        case ExprType::NUMBER:
+        case ExprType::RANDOM:
+            return ValueType::NUMBER;
+        case ExprType::STRING:
+            return ValueType::STRING;
+        case ExprType::VARIABLE: {
+            ValueType type = slotTypes[expr.slot];
+            if (!expr.checked || type == ValueType::NUMBER) return type;
+            return type == ValueType::NONE ? ValueType::NUMBER : ValueType::ANY;
+        }
+        case ExprType::BINARY: {
+            if (expr.op != '+') return ValueType::NUMBER;
+            ValueType left = typeOf(*expr.left), right = typeOf(*expr.right);
+            if (left == ValueType::STRING || right == ValueType::STRING) return ValueType::STRING;
+            if (left == ValueType::ANY || right == ValueType::ANY) return ValueType::ANY;
+            if (left == ValueType::NONE || right == ValueType::NONE) return ValueType::NONE;
+            return ValueType::NUMBER;
+        }
+    }
+    return ValueType::ANY;
+}
+
+// Same rule as Optimizer::isPure: evaluating the expression reports
+// nothing and draws no random numbers, so it may be evaluated in any order
+// relative to other expressions.
+bool Transpiler::isPure(const Expr& expr) const {
+    switch (expr.type) {
+        case ExprType::NUMBER:
+        case ExprType::STRING:
+            return true;
+        case ExprType::VARIABLE:
+            return !expr.checked;
+        case ExprType::RANDOM:
+            return false;
+        case ExprType::BINARY:
+            if (!isPure(*expr.left) || !isPure(*expr.right)) return false;
+            if (expr.op == '+') return true;
+            if (typeOf(*expr.left) != ValueType::NUMBER || typeOf(*expr.right) != ValueType::NUMBER) return false;
+            return expr.op != '/' || isNonZeroNumber(*expr.right);
+    }
+    return false;
+}
+
+void Transpiler::emitBlock(const Block& block) {
+    for (const auto& stmt : block) {
+        emitStatement(*stmt);
+    }
+}
+
+void Transpiler::emitStatement(const Stmt& stmt) {
+    switch (stmt.type) {
+        case StmtType::ASSIGN:
+            emitAssign(stmt);
+            break;
+        case StmtType::COMPOUND_ASSIGN:
+        case StmtType::INCREMENT:
+        case StmtType::DECREMENT:
+            // The right-hand side is only evaluated when the target exists.
+            if (stmt.checked) {
+                line("if (!" + definedFlag(stmt.slot) + ") {");
+                line("    native::undefined(" + stringLiteral(stmt.name) + ");");
+                line("} else {");
+                ++depth;
+                emitUpdate(stmt);
+                --depth;
+                line("}");
+            } else {
+                emitUpdate(stmt);
+            }
+            break;
+        case StmtType::PRINT:
+            line("gum.print(" + emitExpression(*stmt.value).code + ");");
+            break;
+        case StmtType::FLUSH:
+            line("gum.flush();");
+            break;
+        case StmtType::IF:
+            emitIf(stmt, 0, emitCondition(*stmt.branches[0].condition), "");
+            break;
+        case StmtType::FOR:
+            emitFor(stmt);
+            break;
+        case StmtType::STEP_LOOP:
+            emitStepLoop(stmt);
+            break;
+    }
+}
+
+void Transpiler::emitAssign(const Stmt& stmt) {
+    const Expr& value = *stmt.value;
+    // 'x x' leaves x as it is; a Variable must not be moved into itself.
+    if (value.type != ExprType::VARIABLE || value.slot != stmt.slot || value.checked) {
+        Value result = emitExpression(value);
+        if (slotTypes[stmt.slot] == ValueType::NUMBER || result.type != ValueType::NUMBER) {
+            line(local(stmt.slot) + " = " + result.code + ";");
+        } else {
+            line(local(stmt.slot) + " = native::value(" + result.code + ");");
+        }
+    }
+    if (checkedSlots[stmt.slot]) line(definedFlag(stmt.slot) + " = true;");
+}
+
+// COMPOUND_ASSIGN, INCREMENT or DECREMENT of a target known to exist.
+void Transpiler::emitUpdate(const Stmt& stmt) {
+    std::string target = local(stmt.slot);
+    bool number = slotTypes[stmt.slot] == ValueType::NUMBER;
+    if (stmt.type == StmtType::INCREMENT || stmt.type == StmtType::DECREMENT) {
+        const char* step = stmt.type == StmtType::INCREMENT ? "1" : "-1";
+        line(number ? target + " += " + step + ";" : "stepVariable(" + target + ", " + step + ");");
+        return;
+    }
+
+    Value right = emitExpression(*stmt.value);
+    std::string op(1, stmt.op);
+    if (number && right.type == ValueType::NUMBER) {
+        if (stmt.op != '/' || isNonZeroNumber(*stmt.value)) {
+            line(target + " " + op + "= " + right.code + ";");
+        } else {
+            line("native::divideAssign(" + target + ", " + right.code + ");");
+        }
+    } else if (number) {
+        line("native::compoundAssignNumber('" + op + "', " + target + ", " + right.code + ");");
+    } else if (right.type == ValueType::NUMBER) {
+        line("compoundAssign('" + op + "', " + target + ", native::value(" + right.code + "));");
+    } else {
+        line("compoundAssign('" + op + "', " + target + ", " + right.code + ");");
+    }
+}
+
+// Writes 'if' for branches[branch] and everything after it. An 'else if'
+// whose condition first needs statements of its own is written as an
+// 'if' nested in the 'else', so those statements only run when reached.
+void Transpiler::emitIf(const Stmt& stmt, size_t branch, const std::string& condition, const std::string& prefix) {
+    line(prefix + "if (" + condition + ") {");
+    ++depth;
+    emitBlock(stmt.branches[branch].body);
+    --depth;
+
+    if (branch + 1 < stmt.branches.size()) {
+        std::string prelude;
+        ++depth;
+        std::string next = captureCondition(*stmt.branches[branch + 1].condition, prelude);
+        --depth;
+        if (prelude.empty()) {
+            emitIf(stmt, branch + 1, next, "} else ");
+        } else {
+            line("} else {");
+            code += prelude;
+            ++depth;
+            emitIf(stmt, branch + 1, next, "");
+            --depth;
+            line("}");
+        }
+    } else if (stmt.hasElse) {
+        line("} else {");
+        ++depth;
+        emitBlock(stmt.elseBody);
+        --depth;
+        line("}");
+    } else {
+        line("}");
+    }
+}
+
+void Transpiler::emitFor(const Stmt& stmt) {
+    std::string counter = "i" + std::to_string(loopDepth);
+    line("for (int " + counter + " = 0; " + counter + " < " + std::to_string(stmt.cycles) + "; ++" + counter + ") {");
+    ++depth;
+    ++loopDepth;
+    emitBlock(stmt.body);
+    --loopDepth;
+    --depth;
+    line("}");
+}
+
+// runStepLoop, unrolled for this loop: the closed form when every target
+// qualifies at run time, the plain loop otherwise. The step sizes are
+// constants, so whether they are whole numbers, and what each target
+// adds up to, is settled here.
+void Transpiler::emitStepLoop(const Stmt& stmt) {
+    if (stmt.cycles <= 0 || stmt.steps.empty()) return;
+
+    std::vector<std::string> checks;
+    std::vector<std::string> updates;
+    bool exact = true;
+    for (size_t i = 0; i < stmt.steps.size(); ++i) {
+        const LoopStep& step = stmt.steps[i];
+        bool seen = false;
+        for (size_t j = 0; j < i; ++j) {
+            seen = seen || stmt.steps[j].slot == step.slot;
+        }
+        if (seen) continue;
+
+        double total = 0, magnitude = 0;
+        for (size_t j = i; j < stmt.steps.size(); ++j) {
+            if (stmt.steps[j].slot != step.slot) continue;
+            const LoopStep& other = stmt.steps[j];
+            double delta = other.type == StmtType::INCREMENT   ? 1
+                           : other.type == StmtType::DECREMENT ? -1
+                           : other.op == '-'                   ? -other.value
+                                                               : other.value;
+            exact = exact && std::trunc(delta) == delta;
+            total += delta;
+            magnitude += std::fabs(delta);
+        }
+        exact = exact && slotTypes[step.slot] != ValueType::STRING;
+
+        std::string target = local(step.slot);
+        checks.push_back("native::exactSteps(" + target + ", " + numberLiteral(stmt.cycles * magnitude) + ")");
+        if (slotTypes[step.slot] == ValueType::NUMBER) {
+            updates.push_back(target + " += " + numberLiteral(stmt.cycles * total) + ";");
+        } else {
+            updates.push_back("native::addSteps(" + target + ", " + numberLiteral(stmt.cycles * total) + ");");
+        }
+    }
+
+    if (exact) {
+        std::string condition;
+        for (const std::string& check : checks) {
+            condition += (condition.empty() ? "" : " && ") + check;
+        }
+        line("if (" + condition + ") {");
+        for (const std::string& update : updates) {
+            line("    " + update);
+        }
+        line("} else {");
+        ++depth;
+    }
+    std::string counter = "i" + std::to_string(loopDepth);
+    line("for (int " + counter + " = 0; " + counter + " < " + std::to_string(stmt.cycles) + "; ++" + counter + ") {");
+    ++depth;
+    for (const LoopStep& step : stmt.steps) {
+        emitStep(step);
+    }
+    --depth;
+    line("}");
+    if (exact) {
+        --depth;
+        line("}");
+    }
+}
+
+// One update of a STEP_LOOP, as runStepLoop replays it.
+void Transpiler::emitStep(const LoopStep& step) {
+    std::string target = local(step.slot);
+    bool number = slotTypes[step.slot] == ValueType::NUMBER;
+    switch (step.type) {
+        case StmtType::INCREMENT:
+            line(number ? target + " += 1;" : "stepVariable(" + target + ", 1);");
+            break;
+        case StmtType::DECREMENT:
+            line(number ? target + " -= 1;" : "stepVariable(" + target + ", -1);");
+            break;
+        default:
+            if (number) {
+                line(target + " " + step.op + "= " + numberLiteral(step.value) + ";");
+            } else {
+                line("compoundAssign('" + std::string(1, step.op) + "', " + target + ", native::value(" +
+                     numberLiteral(step.value) + "));");
+            }
+            break;
+    }
+}
+
+// A C++ bool expression for 'condition'. Operands that must run in order
+// are stored in temporaries first; the second operand of '&&' or '||' only
+// runs when needed, inside an if, when it needs any.
+std::string Transpiler::emitCondition(const Condition& condition) {
+    if (condition.type != ConditionType::COMPARE) {
+        bool isAnd = condition.type == ConditionType::AND;
+        std::string first = emitCondition(*condition.first);
+        std::string prelude;
+        ++depth;
+        std::string second = captureCondition(*condition.second, prelude);
+        --depth;
+        if (prelude.empty()) return "(" + first + (isAnd ? " && " : " || ") + second + ")";
+
+        std::string flag = "c" + std::to_string(temporaries++);
+        line("bool " + flag + " = " + first + ";");
+        line(std::string("if (") + (isAnd ? "" : "!") + flag + ") {");
+        code += prelude;
+        line("    " + flag + " = " + second + ";");
+        line("}");
+        return flag;
+    }
+
+    Value left = emitOperand(*condition.left, *condition.right);
+    Value right = emitExpression(*condition.right);
+    if (left.type == ValueType::NUMBER && right.type == ValueType::NUMBER) {
+        return "(" + left.code + " " + compareSpelling(condition.op) + " " + right.code + ")";
+    }
+    std::string leftCode = left.type == ValueType::NUMBER ? "native::value(" + left.code + ")" : left.code;
+    std::string rightCode = right.type == ValueType::NUMBER ? "native::value(" + right.code + ")" : right.code;
+    return std::string("compareValues(") + compareName(condition.op) + ", " + leftCode + ", " + rightCode + ")";
+}
+
+// Emits 'condition' into 'prelude' instead of the output.
+std::string Transpiler::captureCondition(const Condition& condition, std::string& prelude) {
+    std::string saved = std::move(code);
+    code.clear();
+    std::string result = emitCondition(condition);
+    prelude = std::move(code);
+    code = std::move(saved);
+    return result;
+}
+
+Transpiler::Value Transpiler::emitExpression(const Expr& expr) {
+    switch (expr.type) {
+        case ExprType::NUMBER:
+            return {numberLiteral(expr.number), ValueType::NUMBER, true};
+        case ExprType::STRING:
+            return {stringConstant(expr.text), ValueType::STRING, true};
+        case ExprType::VARIABLE: {
+            ValueType type = typeOf(expr);
+            if (expr.checked) {
+                const char* fallback = type == ValueType::NUMBER ? "native::undefined(" : "native::undefinedValue(";
+                return {"(" + definedFlag(expr.slot) + " ? " + local(expr.slot) + " : " + fallback +
+                            stringLiteral(expr.text) + "))",
+                        type, false};
+            }
+            if (expr.lastUse && type != ValueType::NUMBER) return {"std::move(" + local(expr.slot) + ")", type, true};
+            return {local(expr.slot), type, true};
+        }
+        case ExprType::RANDOM:
+            return {"gum.random(" + std::to_string(expr.minValue) + ", " + std::to_string(expr.maxValue) + ")",
+                    ValueType::NUMBER, false};
+        case ExprType::BINARY:
+            return emitBinary(expr);
+    }
+    return {"0.0", ValueType::NUMBER, true};
+}
+
+Transpiler::Value Transpiler::emitBinary(const Expr& expr) {
+    Value left = emitOperand(*expr.left, *expr.right);
+    Value right = emitExpression(*expr.right);
+    ValueType type = typeOf(expr);
+    bool pure = isPure(expr);
+    std::string op(1, expr.op);
+
+    if (left.type == ValueType::NUMBER && right.type == ValueType::NUMBER) {
+        if (expr.op == '/' && !isNonZeroNumber(*expr.right)) {
+            return {"native::divide(" + left.code + ", " + right.code + ")", type, pure};
+        }
+        return {"(" + left.code + " " + op + " " + right.code + ")", type, pure};
+    }
+    std::string leftCode = left.type == ValueType::NUMBER ? "native::value(" + left.code + ")" : left.code;
+    std::string rightCode = right.type == ValueType::NUMBER ? "native::value(" + right.code + ")" : right.code;
+    const char* function = expr.op == '+' ? "native::binary('" : "native::arithmetic('";
+    return {function + op + "', " + leftCode + ", " + rightCode + ")", type, pure};
+}
+
+// Emits the left operand of a pair. C++ leaves the order of operands
+// open, so when both sides have effects the left one is stored in a
+// temporary before the right one is emitted.
+Transpiler::Value Transpiler::emitOperand(const Expr& expr, const Expr& next) {
+    Value value = emitExpression(expr);
+    if (!value.pure && !isPure(next)) return materialize(value);
+    return value;
+}
+
+Transpiler::Value Transpiler::materialize(const Value& value) {
+    std::string name = "t" + std::to_string(temporaries++);
+    if (value.type == ValueType::NUMBER) {
+        line("const double " + name + " = " + value.code + ";");
+        return {name, value.type, true};
+    }
+    line("Variable " + name + " = " + value.code + ";");
+    return {"std::move(" + name + ")", value.type, true};
+}
+
+// String literals become Variables built once before the program runs, so
+// using one only bumps a reference count.
+std::string Transpiler::stringConstant(const std::string& text) {
+    auto found = strings.find(text);
+    int index = found != strings.end() ? found->second : static_cast<int>(strings.size());
+    if (found == strings.end()) strings.emplace(text, index);
+    return "s" + std::to_string(index);
+}
+
+void Transpiler::line(const std::string& text) {
+    code.append(depth * 4, ' ');
+    code += text;
+    code += '\n';
+}
+
+std::string Transpiler::local(int slot) const {
+    return "v" + std::to_string(slot);
+}
+
+std::string Transpiler::definedFlag(int slot) const {
+    return "v" + std::to_string(slot) + "Defined";
+}
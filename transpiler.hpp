@@ -0,0 +1,78 @@
+#ifndef TRANSPILER_HPP
+#define TRANSPILER_HPP
+
+#include "ast.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace GUMLANG {
+
+// Ahead-of-time back end: writes a resolved, optimized Program as one C++
+// translation unit with its own main(), to be built against native.hpp.
+// Every variable becomes a local of main(): a double when it only ever
+// holds numbers, a Variable otherwise. 'for' becomes a counted C++ loop,
+// and printing, 'random' and error reports go through native::Runtime and
+// the runtime.hpp functions, so the executable prints exactly what the
+// interpreters print for the same source and --seed.
+class Transpiler {
+public:
+    std::string transpile(const Program& program, const std::string& sourceName);
+
+private:
+    // What a variable or expression can hold. NONE is only seen while
+    // findSlotTypes is still working out the slots.
+    enum class ValueType {
+        NONE,
+        NUMBER,
+        STRING,
+        ANY
+    };
+
+    // A C++ expression: a double when 'type' is NUMBER, a Variable
+    // otherwise. A pure one reports no errors and draws no random numbers.
+    struct Value {
+        std::string code;
+        ValueType type;
+        bool pure;
+    };
+
+    void findSlotTypes(const Program& program);
+    void collectSlotUses(const Block& block, std::vector<const Stmt*>& assignments);
+    void collectCheckedReads(const Expr& expr);
+    void collectCheckedReads(const Condition& condition);
+    ValueType typeOf(const Expr& expr) const;
+    bool isPure(const Expr& expr) const;
+
+    void emitBlock(const Block& block);
+    void emitStatement(const Stmt& stmt);
+    void emitAssign(const Stmt& stmt);
+    void emitUpdate(const Stmt& stmt);
+    void emitIf(const Stmt& stmt, size_t branch, const std::string& condition, const std::string& prefix);
+    void emitFor(const Stmt& stmt);
+    void emitStepLoop(const Stmt& stmt);
+    void emitStep(const LoopStep& step);
+    std::string emitCondition(const Condition& condition);
+    std::string captureCondition(const Condition& condition, std::string& prelude);
+    Value emitExpression(const Expr& expr);
+    Value emitBinary(const Expr& expr);
+    Value emitOperand(const Expr& expr, const Expr& next);
+    Value materialize(const Value& value);
+    std::string stringConstant(const std::string& text);
+
+    void line(const std::string& text);
+    std::string local(int slot) const;
+    std::string definedFlag(int slot) const;
+
+    std::vector<ValueType> slotTypes;
+    std::vector<bool> checkedSlots; // needs a flag recording whether it was assigned
+    std::map<std::string, int> strings;
+    std::string code;
+    int depth = 1;
+    int loopDepth = 0;
+    int temporaries = 0;
+};
+
+} // namespace GUMLANG
+
+#endif // TRANSPILER_HPP
@@ -1,45 +1,128 @@
 #include "variable.hpp"
+#include <cmath>
+#include <cstring>
 
-Variable::Variable() : type(VariableType::NUMBER), numberValue(0.0) {}
+Variable::Variable() : type(VariableType::INTEGER), integerValue(0) {}
 
-Variable::Variable(const std::string& name, double val)
+Variable::Variable(double val)
     : type(VariableType::NUMBER), numberValue(val) {}
 
-Variable::Variable(const std::string& name, const std::string& val)
-    : type(VariableType::STRING), value(val) {}
+Variable::Variable(int64_t val)
+    : type(VariableType::INTEGER), integerValue(val) {}
 
-void Variable::add(const Variable& other)
+Variable Variable::number(double val)
 {
-    if (type == VariableType::NUMBER && other.type == VariableType::NUMBER)
+    const double limit = static_cast<double>(integerLimit);
+    if (val > -limit && val < limit && std::trunc(val) == val)
     {
-        numberValue += other.numberValue;
+        return Variable(static_cast<int64_t>(val));
     }
-    else if (type == VariableType::STRING && other.type == VariableType::STRING)
+    return Variable(val);
+}
+
+Variable::Variable(const std::string& val)
+    : type(VariableType::STRING), stringObject(new StringObject{1, val}) {}
+
+Variable::Variable(std::string&& val)
+    : type(VariableType::STRING), stringObject(new StringObject{1, std::move(val)}) {}
+
+Variable::Variable(const Variable& other)
+    : type(other.type)
+{
+    if (type == VariableType::STRING)
+    {
+        stringObject = other.stringObject;
+        stringObject->refCount++;
+    }
+    else
     {
-        value += other.value;
+        copyNumber(other);
     }
 }
 
-void Variable::subtract(const Variable& other)
+Variable::Variable(Variable&& other) noexcept
+    : type(other.type)
 {
-    if (type == VariableType::NUMBER && other.type == VariableType::NUMBER)
+    if (type == VariableType::STRING)
     {
-        numberValue -= other.numberValue;
+        stringObject = other.stringObject;
+        other.type = VariableType::INTEGER;
+        other.integerValue = 0;
+    }
+    else
+    {
+        copyNumber(other);
     }
 }
 
-void Variable::multiply(const Variable& other)
+Variable& Variable::operator=(const Variable& other)
 {
-    if (type == VariableType::NUMBER && other.type == VariableType::NUMBER)
+    if (other.type == VariableType::STRING)
+    {
+        other.stringObject->refCount++;
+    }
+    release();
+    type = other.type;
+    if (type == VariableType::STRING)
     {
-        numberValue *= other.numberValue;
+        stringObject = other.stringObject;
     }
+    else
+    {
+        copyNumber(other);
+    }
+    return *this;
+}
+
+Variable& Variable::operator=(Variable&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        type = other.type;
+        if (type == VariableType::STRING)
+        {
+            stringObject = other.stringObject;
+            other.type = VariableType::INTEGER;
+            other.integerValue = 0;
+        }
+        else
+        {
+            copyNumber(other);
+        }
+    }
+    return *this;
+}
+
+Variable::~Variable()
+{
+    release();
+}
+
+void Variable::appendString(std::string_view suffix)
+{
+    if (stringObject->refCount > 1)
+    {
+        // Copy on write: other Variables still see the old text.
+        StringObject* copy = new StringObject{1, std::string()};
+        copy->text.reserve(stringObject->text.size() + suffix.size());
+        copy->text = stringObject->text;
+        stringObject->refCount--;
+        stringObject = copy;
+    }
+    stringObject->text += suffix;
+}
+
+void Variable::copyNumber(const Variable& other)
+{
+    // Either member; copying the bytes avoids branching on which.
+    std::memcpy(&numberValue, &other.numberValue, sizeof numberValue);
 }
 
-void Variable::divide(const Variable& other)
+void Variable::release()
 {
-    if (type == VariableType::NUMBER && other.type == VariableType::NUMBER)
+    if (type == VariableType::STRING && --stringObject->refCount == 0)
     {
-        numberValue /= other.numberValue;
+        delete stringObject;
     }
 }
@@ -1,29 +1,71 @@
 #ifndef VARIABLE_HPP
 #define VARIABLE_HPP
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
-enum class VariableType
+enum class VariableType : uint8_t
 {
-    NUMBER,
+    NUMBER,  // double
+    INTEGER, // int64_t, always below 2^53 in magnitude
     STRING
 };
 
+// Shared, reference-counted string storage. Copies of a string Variable
+// share one StringObject; it is only copied when a shared string is
+// modified in place.
+struct StringObject
+{
+    uint32_t refCount;
+    std::string text;
+};
+
+// A 16-byte tagged value: numbers are stored inline, strings as a handle to
+// a StringObject, so numeric code never touches the heap.
+//
+// Integer-valued numbers are kept as INTEGER so counters and random values
+// use integer arithmetic. An INTEGER is always below 2^53 in magnitude, so
+// it converts to double exactly and behaves exactly like the same NUMBER;
+// operations whose result would leave that range produce a NUMBER instead.
 class Variable
 {
 public:
     VariableType type;
-    double numberValue;
-    std::string value;
+    union
+    {
+        double numberValue;
+        int64_t integerValue;
+        StringObject* stringObject;
+    };
 
     Variable();
-    Variable(const std::string& name, double val);
-    Variable(const std::string& name, const std::string& val);
+    explicit Variable(double val);
+    explicit Variable(int64_t val);
+    explicit Variable(const std::string& val);
+    explicit Variable(std::string&& val);
+    Variable(const Variable& other);
+    Variable(Variable&& other) noexcept;
+    Variable& operator=(const Variable& other);
+    Variable& operator=(Variable&& other) noexcept;
+    ~Variable();
+
+    // An INTEGER when 'val' is a whole number in range, a NUMBER otherwise.
+    static Variable number(double val);
 
-    void add(const Variable& other);
-    void subtract(const Variable& other);
-    void multiply(const Variable& other);
-    void divide(const Variable& other);
+    bool isNumber() const { return type != VariableType::STRING; }
+    double toNumber() const { return type == VariableType::INTEGER ? static_cast<double>(integerValue) : numberValue; }
+    const std::string& stringValue() const { return stringObject->text; }
+    void appendString(std::string_view suffix);
+
+    static constexpr int64_t integerLimit = int64_t(1) << 53;
+    static bool inIntegerRange(int64_t val) { return val > -integerLimit && val < integerLimit; }
+
+private:
+    void copyNumber(const Variable& other);
+    void release();
 };
 
+static_assert(sizeof(Variable) == 16, "Variable should stay a 16-byte tagged value");
+
 #endif // VARIABLE_HPP
@@ -0,0 +1,341 @@
+#include "vm.hpp"
+#include "runtime.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+using namespace GUMLANG;
+
+void VM::run(const Chunk& chunk, Dispatch dispatch) {
+    run(chunk.view(), dispatch);
+}
+
+void VM::run(const ChunkView& chunk, Dispatch dispatch) {
+    slots.assign(chunk.slotNames.size(), Variable());
+    defined.assign(chunk.slotNames.size(), false);
+    counters.assign(chunk.loopCount, 0);
+    stack.clear();
+
+    // Constants are built once: numbers already quickened to INTEGER where
+    // they can be, strings so that pushing one only bumps a refcount.
+    numbers.clear();
+    for (size_t i = 0; i < chunk.numberCount; ++i) {
+        numbers.push_back(Variable::number(chunk.numbers[i]));
+    }
+    strings.clear();
+    for (std::string_view text : chunk.strings) {
+        strings.emplace_back(std::string(text));
+    }
+
+    bool threaded = dispatch == Dispatch::THREADED && GUM_DISPATCH_THREADED;
+    if (counting) {
+        threaded ? execute<true, true>(chunk) : execute<false, true>(chunk);
+    } else {
+        threaded ? execute<true, false>(chunk) : execute<false, false>(chunk);
+    }
+}
+
+void VM::countInstructions(bool enabled) {
+    counting = enabled;
+    instructionCounts.assign(static_cast<size_t>(OpCode::HALT) + 1, 0);
+}
+
+static const char* opcodeName(OpCode op) {
+    switch (op) {
+        case OpCode::PUSH_NUMBER: return "PUSH_NUMBER";
+        case OpCode::PUSH_STRING: return "PUSH_STRING";
+        case OpCode::LOAD: return "LOAD";
+        case OpCode::LOAD_CHECKED: return "LOAD_CHECKED";
+        case OpCode::TAKE: return "TAKE";
+        case OpCode::STORE: return "STORE";
+        case OpCode::ADD: return "ADD";
+        case OpCode::SUBTRACT: return "SUBTRACT";
+        case OpCode::MULTIPLY: return "MULTIPLY";
+        case OpCode::DIVIDE: return "DIVIDE";
+        case OpCode::ADD_ASSIGN: return "ADD_ASSIGN";
+        case OpCode::SUBTRACT_ASSIGN: return "SUBTRACT_ASSIGN";
+        case OpCode::MULTIPLY_ASSIGN: return "MULTIPLY_ASSIGN";
+        case OpCode::DIVIDE_ASSIGN: return "DIVIDE_ASSIGN";
+        case OpCode::INCREMENT: return "INCREMENT";
+        case OpCode::DECREMENT: return "DECREMENT";
+        case OpCode::EQUAL: return "EQUAL";
+        case OpCode::NOT_EQUAL: return "NOT_EQUAL";
+        case OpCode::LESS: return "LESS";
+        case OpCode::GREATER: return "GREATER";
+        case OpCode::LESS_EQUAL: return "LESS_EQUAL";
+        case OpCode::GREATER_EQUAL: return "GREATER_EQUAL";
+        case OpCode::JUMP: return "JUMP";
+        case OpCode::JUMP_IF_FALSE: return "JUMP_IF_FALSE";
+        case OpCode::JUMP_IF_UNDEFINED: return "JUMP_IF_UNDEFINED";
+        case OpCode::LOOP_START: return "LOOP_START";
+        case OpCode::LOOP_NEXT: return "LOOP_NEXT";
+        case OpCode::STEP_LOOP: return "STEP_LOOP";
+        case OpCode::PRINT: return "PRINT";
+        case OpCode::FLUSH: return "FLUSH";
+        case OpCode::RANDOM: return "RANDOM";
+        case OpCode::ADD_SLOT_CONST: return "ADD_SLOT_CONST";
+        case OpCode::SUBTRACT_SLOT_CONST: return "SUBTRACT_SLOT_CONST";
+        case OpCode::MOVE_SLOT: return "MOVE_SLOT";
+        case OpCode::CMP_SLOT_CONST_JUMP: return "CMP_SLOT_CONST_JUMP";
+        case OpCode::HALT: return "HALT";
+    }
+    return "?";
+}
+
+// One line per opcode that ran, most frequent first, with fused forms
+// marked and summed at the end.
+void VM::printInstructionCounts(std::ostream& out) const {
+    std::vector<size_t> order;
+    uint64_t total = 0, fusedTotal = 0;
+    for (size_t op = 0; op < instructionCounts.size(); ++op) {
+        if (instructionCounts[op] == 0) continue;
+        order.push_back(op);
+        total += instructionCounts[op];
+        if (op >= static_cast<size_t>(OpCode::ADD_SLOT_CONST) && op < static_cast<size_t>(OpCode::HALT)) {
+            fusedTotal += instructionCounts[op];
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](size_t x, size_t y) {
+        return instructionCounts[x] > instructionCounts[y];
+    });
+
+    for (size_t op : order) {
+        bool fused = op >= static_cast<size_t>(OpCode::ADD_SLOT_CONST) && op < static_cast<size_t>(OpCode::HALT);
+        out << std::setw(22) << std::left << opcodeName(static_cast<OpCode>(op)) << std::setw(14) << std::right
+            << instructionCounts[op] << (fused ? "  fused" : "") << '\n';
+    }
+    out << "instructions executed: " << total << ", fused: " << fusedTotal << '\n';
+}
+
+// Both dispatch strategies share these handlers. Every handler starts with
+// HANDLER(op), which is a case label and, when threaded dispatch is built,
+// also the target of the jump table; it ends with NEXT(), which either
+// jumps straight to the next handler or returns to the switch.
+// When 'withCounts' is set, every dispatch also bumps the opcode's counter.
+#define COUNT()                                                         \
+    do {                                                                \
+        if constexpr (withCounts) instructionCounts[static_cast<uint8_t>(ins->op)]++; \
+    } while (false)
+#if GUM_DISPATCH_THREADED
+#define HANDLER(name) case OpCode::name: handle_##name
+#define NEXT()                                                 \
+    do {                                                       \
+        if constexpr (threaded) {                              \
+            ins = &code[pc++];                                 \
+            COUNT();                                           \
+            goto *handlers[static_cast<uint8_t>(ins->op)];     \
+        }                                                      \
+        goto dispatch;                                         \
+    } while (false)
+#else
+#define HANDLER(name) case OpCode::name
+#define NEXT() goto dispatch
+#endif
+
+template <bool threaded, bool withCounts>
+void VM::execute(const ChunkView& chunk) {
+    const Instruction* code = chunk.code;
+    const Instruction* ins;
+    size_t pc = 0;
+
+#if GUM_DISPATCH_THREADED
+    // Indexed by OpCode, so the entries must stay in declaration order.
+    static void* const handlers[] = {
+        &&handle_PUSH_NUMBER, &&handle_PUSH_STRING, &&handle_LOAD, &&handle_LOAD_CHECKED,
+        &&handle_TAKE, &&handle_STORE, &&handle_ADD, &&handle_SUBTRACT, &&handle_MULTIPLY, &&handle_DIVIDE,
+        &&handle_ADD_ASSIGN, &&handle_SUBTRACT_ASSIGN, &&handle_MULTIPLY_ASSIGN, &&handle_DIVIDE_ASSIGN,
+        &&handle_INCREMENT, &&handle_DECREMENT, &&handle_EQUAL, &&handle_NOT_EQUAL, &&handle_LESS,
+        &&handle_GREATER, &&handle_LESS_EQUAL, &&handle_GREATER_EQUAL, &&handle_JUMP,
+        &&handle_JUMP_IF_FALSE, &&handle_JUMP_IF_UNDEFINED, &&handle_LOOP_START, &&handle_LOOP_NEXT,
+        &&handle_STEP_LOOP, &&handle_PRINT, &&handle_FLUSH, &&handle_RANDOM, &&handle_ADD_SLOT_CONST,
+        &&handle_SUBTRACT_SLOT_CONST, &&handle_MOVE_SLOT, &&handle_CMP_SLOT_CONST_JUMP, &&handle_HALT,
+    };
+    static_assert(sizeof handlers / sizeof handlers[0] == static_cast<size_t>(OpCode::HALT) + 1,
+                  "every OpCode needs a handler");
+#endif
+
+    auto undefined = [&](int slot) {
+        std::cerr << "Undefined variable: " << chunk.slotNames[slot] << std::endl;
+    };
+    auto pop = [&]() {
+        Variable value = std::move(stack.back());
+        stack.pop_back();
+        return value;
+    };
+    // Binary operators and comparisons leave their result in the left
+    // operand's stack entry; numbers are written into it directly.
+    auto binary = [&](char op) {
+        Variable& left = stack[stack.size() - 2];
+        if (!numericBinary(op, left, stack.back(), left)) applyBinary(op, left, stack.back());
+        stack.pop_back();
+    };
+    auto compare = [&](CompareOp op) {
+        Variable& left = stack[stack.size() - 2];
+        double result = compareValues(op, left, stack.back()) ? 1.0 : 0.0;
+        if (left.isNumber()) {
+            left.type = VariableType::NUMBER;
+            left.numberValue = result;
+        } else {
+            left = Variable(result);
+        }
+        stack.pop_back();
+    };
+    auto assign = [&](char op, int slot) {
+        compoundAssign(op, slots[slot], stack.back());
+        stack.pop_back();
+    };
+
+dispatch:
+    ins = &code[pc++];
+    COUNT();
+    switch (ins->op) {
+        HANDLER(PUSH_NUMBER):
+            stack.push_back(numbers[ins->a]);
+            NEXT();
+        HANDLER(PUSH_STRING):
+            stack.push_back(strings[ins->a]);
+            NEXT();
+        HANDLER(LOAD):
+            stack.push_back(slots[ins->a]);
+            NEXT();
+        HANDLER(LOAD_CHECKED):
+            if (defined[ins->a]) {
+                stack.push_back(slots[ins->a]);
+            } else {
+                undefined(ins->a);
+                stack.push_back(Variable(0.0));
+            }
+            NEXT();
+        HANDLER(TAKE):
+            stack.push_back(std::move(slots[ins->a]));
+            NEXT();
+        HANDLER(STORE):
+            slots[ins->a] = pop();
+            defined[ins->a] = true;
+            NEXT();
+        HANDLER(ADD): binary('+'); NEXT();
+        HANDLER(SUBTRACT): binary('-'); NEXT();
+        HANDLER(MULTIPLY): binary('*'); NEXT();
+        HANDLER(DIVIDE): binary('/'); NEXT();
+        HANDLER(ADD_ASSIGN): assign('+', ins->a); NEXT();
+        HANDLER(SUBTRACT_ASSIGN): assign('-', ins->a); NEXT();
+        HANDLER(MULTIPLY_ASSIGN): assign('*', ins->a); NEXT();
+        HANDLER(DIVIDE_ASSIGN): assign('/', ins->a); NEXT();
+        HANDLER(INCREMENT): {
+            Variable& target = slots[ins->a];
+            if (target.type == VariableType::INTEGER && Variable::inIntegerRange(target.integerValue + 1)) {
+                target.integerValue += 1;
+            } else if (target.type == VariableType::NUMBER) {
+                target.numberValue += 1;
+            } else {
+                stepVariable(target, 1);
+            }
+            NEXT();
+        }
+        HANDLER(DECREMENT): {
+            Variable& target = slots[ins->a];
+            if (target.type == VariableType::INTEGER && Variable::inIntegerRange(target.integerValue - 1)) {
+                target.integerValue -= 1;
+            } else if (target.type == VariableType::NUMBER) {
+                target.numberValue -= 1;
+            } else {
+                stepVariable(target, -1);
+            }
+            NEXT();
+        }
+        HANDLER(EQUAL): compare(CompareOp::EQUAL); NEXT();
+        HANDLER(NOT_EQUAL): compare(CompareOp::NOT_EQUAL); NEXT();
+        HANDLER(LESS): compare(CompareOp::LESS); NEXT();
+        HANDLER(GREATER): compare(CompareOp::GREATER); NEXT();
+        HANDLER(LESS_EQUAL): compare(CompareOp::LESS_EQUAL); NEXT();
+        HANDLER(GREATER_EQUAL): compare(CompareOp::GREATER_EQUAL); NEXT();
+        HANDLER(JUMP):
+            pc = ins->a;
+            NEXT();
+        HANDLER(JUMP_IF_FALSE):
+            if (pop().numberValue == 0) pc = ins->a;
+            NEXT();
+        HANDLER(JUMP_IF_UNDEFINED):
+            if (!defined[ins->a]) {
+                undefined(ins->a);
+                pc = ins->b;
+            }
+            NEXT();
+        HANDLER(LOOP_START):
+            counters[ins->a] = ins->b;
+            NEXT();
+        HANDLER(LOOP_NEXT):
+            if (counters[ins->a]-- > 0) pc = ins->b;
+            NEXT();
+        HANDLER(STEP_LOOP):
+            runStepLoop(ins->b, chunk.loopSteps + chunk.stepLoops[ins->a].first, chunk.stepLoops[ins->a].count,
+                        slots.data());
+            NEXT();
+        HANDLER(PRINT):
+            printValue(pop(), out);
+            NEXT();
+        HANDLER(FLUSH):
+            out.flush();
+            NEXT();
+        HANDLER(RANDOM):
+            stack.push_back(Variable(random.between(ins->a, ins->b)));
+            NEXT();
+        HANDLER(ADD_SLOT_CONST): {
+            Variable& target = slots[ins->a];
+            const Variable& constant = numbers[ins->b];
+            if (target.type == VariableType::INTEGER && constant.type == VariableType::INTEGER &&
+                Variable::inIntegerRange(target.integerValue + constant.integerValue)) {
+                target.integerValue += constant.integerValue;
+            } else if (target.type == VariableType::NUMBER) {
+                target.numberValue += chunk.numbers[ins->b];
+            } else {
+                compoundAssign('+', target, constant);
+            }
+            NEXT();
+        }
+        HANDLER(SUBTRACT_SLOT_CONST): {
+            Variable& target = slots[ins->a];
+            const Variable& constant = numbers[ins->b];
+            if (target.type == VariableType::INTEGER && constant.type == VariableType::INTEGER &&
+                Variable::inIntegerRange(target.integerValue - constant.integerValue)) {
+                target.integerValue -= constant.integerValue;
+            } else if (target.type == VariableType::NUMBER) {
+                target.numberValue -= chunk.numbers[ins->b];
+            } else {
+                compoundAssign('-', target, constant);
+            }
+            NEXT();
+        }
+        HANDLER(MOVE_SLOT):
+            slots[ins->a] = slots[ins->b];
+            defined[ins->a] = true;
+            NEXT();
+        HANDLER(CMP_SLOT_CONST_JUMP): {
+            const Variable& value = slots[ins->a];
+            double constant = chunk.numbers[ins->b];
+            CompareOp compare = static_cast<CompareOp>(ins->variant);
+            bool holds;
+            if (value.isNumber()) {
+                // An INTEGER converts to double exactly.
+                double number = value.toNumber();
+                switch (compare) {
+                    case CompareOp::EQUAL: holds = number == constant; break;
+                    case CompareOp::NOT_EQUAL: holds = number != constant; break;
+                    case CompareOp::LESS: holds = number < constant; break;
+                    case CompareOp::GREATER: holds = number > constant; break;
+                    case CompareOp::LESS_EQUAL: holds = number <= constant; break;
+                    default: holds = number >= constant; break;
+                }
+            } else {
+                holds = compareValues(compare, value, numbers[ins->b]);
+            }
+            if (!holds) pc = ins->c;
+            NEXT();
+        }
+        HANDLER(HALT):
+            return;
+    }
+}
+
+#undef COUNT
+#undef HANDLER
+#undef NEXT
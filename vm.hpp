@@ -0,0 +1,66 @@
+#ifndef VM_HPP
+#define VM_HPP
+
+#include "bytecode.hpp"
+#include "output.hpp"
+#include "random.hpp"
+#include "variable.hpp"
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Threaded dispatch needs the labels-as-values extension of GCC and Clang.
+// Build with -DGUM_DISPATCH_SWITCH to use the portable switch everywhere.
+#if defined(__GNUC__) && !defined(GUM_DISPATCH_SWITCH)
+#define GUM_DISPATCH_THREADED 1
+#else
+#define GUM_DISPATCH_THREADED 0
+#endif
+
+namespace GUMLANG {
+
+// How the VM moves from one instruction to the next. SWITCH returns to a
+// single switch after every instruction; THREADED ends every handler with
+// its own indirect jump to the next handler, which branch predictors
+// handle much better. THREADED falls back to SWITCH when it is not built.
+enum class Dispatch {
+    SWITCH,
+    THREADED
+};
+
+// Stack machine that executes a compiled Chunk.
+class VM {
+public:
+    static constexpr Dispatch defaultDispatch = GUM_DISPATCH_THREADED ? Dispatch::THREADED : Dispatch::SWITCH;
+
+    explicit VM(OutputSink& out = standardOutput(), uint64_t seed = RandomEngine::randomSeed())
+        : out(out), random(seed) {}
+
+    void run(const Chunk& chunk, Dispatch dispatch = defaultDispatch);
+    void run(const ChunkView& chunk, Dispatch dispatch = defaultDispatch);
+
+    // Instrumentation: while enabled, runs count how many times each
+    // opcode executes, fused forms included.
+    void countInstructions(bool enabled);
+    void printInstructionCounts(std::ostream& out) const;
+
+private:
+    template <bool threaded, bool withCounts>
+    void execute(const ChunkView& chunk);
+
+    OutputSink& out;
+    RandomEngine random;
+    bool counting = false;
+    std::vector<uint64_t> instructionCounts;
+
+    std::vector<Variable> numbers;
+    std::vector<Variable> strings;
+    std::vector<Variable> slots;
+    std::vector<bool> defined;
+    std::vector<Variable> stack;
+    std::vector<int> counters;
+};
+
+} // namespace GUMLANG
+
+#endif // VM_HPP